@@ -5,27 +5,70 @@
 #include "orchard.h"
 #include "orchard-events.h"
 #include "analog.h"
+#include "stream.h"
+#include "trigger.h"
 
 #include "chbsem.h"
 
-adcsample_t scope_sample[SCOPE_SAMPLE_DEPTH];
+// capture ring: the ADC writes it continuously, the trigger picks a window out of it
+adcsample_t scope_sample[SCOPE_RING_DEPTH];
 extern uint8_t cmp_init;
 extern event_source_t cmp_event;
 
+// ping-pong frames: the ISR fills whichever one the UI isn't drawing
+static adcsample_t scope_bufs[2][SCOPE_SAMPLE_DEPTH];
+static volatile int8_t scope_busy = -1;  // frame held by the UI, or -1
+static volatile int8_t scope_ready = -1; // newest complete frame not yet taken, or -1
+static volatile int16_t scope_trigger_index = -1; // ring index of the first post-trigger sample
+static uint8_t scope_running = 0;
+static uint16_t scope_pretrigger = (SCOPE_SAMPLE_DEPTH * SCOPE_PRETRIGGER_DEFAULT) / 100;
+
+/*
+  Called once per completed half of the ring. Once enough post-trigger samples
+  have landed, copy the window around the trigger out to the UI. Since the
+  window is at most half the ring and we copy from inside the ADC interrupt,
+  the writer can never lap the start of the window before we're done with it.
+  A frame the UI never picked up is simply overwritten by the next one.
+ */
 void adc_cb(ADCDriver *adcp, adcsample_t *buffer, size_t n) {
+  adcsample_t *frame;
+  int16_t trig;
+  uint16_t since, start;
+  int8_t target;
+  int i;
+
   (void) adcp;
-  (void) buffer;
-  (void) n;
-  
-  if( cmp_init ) {
-    osalSysLockFromISR();
+
+  osalSysLockFromISR();
+  streamBlockI(buffer, n);
+  osalSysUnlockFromISR();
+
+  trig = scope_trigger_index;
+  if( trig < 0 )
+    return;
+
+  // samples written since the trigger, up to the end of this half
+  since = ((buffer - scope_sample) + n - trig) & (SCOPE_RING_DEPTH - 1);
+  if( since < (SCOPE_SAMPLE_DEPTH - scope_pretrigger) )
+    return;
+
+  target = (scope_busy == 0) ? 1 : 0;
+  frame = scope_bufs[target];
+  start = (trig - scope_pretrigger) & (SCOPE_RING_DEPTH - 1);
+  for( i = 0; i < SCOPE_SAMPLE_DEPTH; i++ )
+    frame[i] = scope_sample[(start + i) & (SCOPE_RING_DEPTH - 1)];
+
+  osalSysLockFromISR();
+  scope_ready = target;
+  scope_trigger_index = -1;
+  triggerRearmI();
+  if( cmp_init )
     chEvtBroadcastI(&cmp_event);
-    osalSysUnlockFromISR();
-  }
+  osalSysUnlockFromISR();
 }
 
 static const ADCConversionGroup lightadc = {
-    0, // circular buffer mode? no.
+    1, // circular buffer mode, callback on each half
     1, // just one channel
     adc_cb,  // callback
     NULL,  // error callback
@@ -36,37 +79,282 @@ static const ADCConversionGroup lightadc = {
     // ADCCLK = SYSCLK / 2 / 1 = 6 MHz
 
     // ADLPC = 0 (normal power)
-    // ADLSMP = 0 (short sample time)
-    // ADHSC = 0 (normal conversion sequence)
-    // -> 5 ADCK cycles + 5 bus clock cycles = SFCadder
-    // 20 ADCK cycles per sample
+    // ADLSMP = 1 (long sample time, CFG2 from the ADCConfig trims it)
+    // ADHSC = 1 (high speed conversion sequence, also from CFG2)
+    // -> ~29 ADCK cycles + 5 bus clock cycles, just under 5us per sample
     
     ADCx_CFG1_ADIV(ADCx_CFG1_ADIV_DIV_2) |
     ADCx_CFG1_ADICLK(ADCx_CFG1_ADIVCLK_BUS_CLOCK_DIV_2) |
     ADCx_CFG1_MODE(ADCx_CFG1_MODE_12_OR_13_BITS) | 0x10,  // 12 bits per sample, add in long sample time
 
     // SC3 register
-    ADCx_SC3_AVGE |
-    ADCx_SC3_AVGS(ADCx_SC3_AVGS_AVERAGE_8_SAMPLES) 
+    0, // one conversion per trigger, the timebase does the pacing
 
-    //      48 MHz sysclk
-    // /2   24 MHz busclk
-    // /2   12 MHz after prescaler
-    // /2   6 MHz after adiv
-    // /17  353ksps after base sample time @ 12 bps
-    // /1   353ksps with no averaging
+    // SOPT7: every TPM1 overflow converts one sample
+    ADC_SOPT7_TRIGGER(SIM_SOPT7_ADC0TRGSEL_TPM1)
   };
 
+/*
+  Timebases, as the period of the TPM1 overflow that triggers each
+  conversion. The fastest must leave room for the conversion itself, and the
+  slowest has to fit the 16 bit counter at the undivided system clock.
+ */
+static const uint16_t scope_timebase_us[] = { 10, 20, 50, 100, 200, 500, 1000 };
+#define SCOPE_TIMEBASES (sizeof(scope_timebase_us) / sizeof(scope_timebase_us[0]))
+
+// nearest whole number of timer counts, the clock isn't a round number of MHz
+#define SCOPE_US_COUNTS(us) \
+  ((uint32_t) (((uint64_t) SCOPE_TIMER_HZ * (us) + 500000) / 1000000))
+
+static uint8_t scope_timebase = SCOPE_TIMEBASE_DEFAULT;
+
+static const PWMConfig scope_timer_config = {
+  SCOPE_TIMER_HZ,  // no prescaler
+  SCOPE_US_COUNTS(100),  // replaced by the timebase at start
+  NULL,
+  {{PWM_OUTPUT_DISABLED, NULL}, {PWM_OUTPUT_DISABLED, NULL}},
+};
+
+static pwmcnt_t scope_timer_period(void) {
+  return SCOPE_US_COUNTS(scope_timebase_us[scope_timebase]);
+}
+
+/*
+  Equivalent time sampling, the timebase after the slowest one. For a
+  repetitive signal, sample slot k of the frame is taken k steps after
+  the k-th trigger, so a frame builds up over SCOPE_SAMPLE_DEPTH triggers
+  at a rate the ADC could never convert in real time.
+
+  No software sits between the edge and the sample: the comparator output
+  starts TPM1 (CSOT), the counter stops itself at the overflow (CSOO), and
+  that overflow fires the conversion just like a real-time timebase.
+  The ADC ignores triggers while it is converting. Its callback then resets
+  the counter, so an edge that arrived during the conversion is discarded
+  too. Only then does it program the next delay.
+ */
+#define SCOPE_TIMEBASE_ETS  SCOPE_TIMEBASES
+#define ETS_STEP_COUNTS     12    // 250ns per slot at 48MHz, 40x the fastest real-time timebase
+#define ETS_DELAY_MIN       4     // counts; the overflow fires MOD + 1 counts after the edge
+#define ETS_TRGSEL_CMP0     1     // TPM trigger table matches SOPT7's, 1 = CMP0 output
+#define TPM_SC_CMOD_MASK    (3 << 3)
+
+static adcsample_t ets_sample[2];
+static volatile uint16_t ets_slot;
+static volatile int8_t ets_target;  // frame being swept, -1 drops it
+
+static void ets_timer_disable(void) {
+
+  PWMD2.tpm->SC &= ~TPM_SC_CMOD_MASK;
+  while( PWMD2.tpm->SC & TPM_SC_CMOD_MASK )
+    ;  // takes effect on the next counter clock
+}
+
+// MOD and CNT load immediately while the counter is off; enabled, it waits for the next edge
+static void ets_timer_arm(uint16_t slot) {
+
+  PWMD2.tpm->MOD = ETS_DELAY_MIN + slot * ETS_STEP_COUNTS;
+  PWMD2.tpm->CNT = 0;
+  PWMD2.tpm->SC |= TPM_SC_CMOD_LPTPM_CLK;
+}
+
+/*
+  The next frame goes into the buffer that is neither published nor being
+  drawn. With both taken it is swept anyway but not stored, -1, so the
+  frame the UI is about to pick up can't be torn under it.
+ */
+static int8_t ets_free_buffer(void) {
+  int8_t b;
+
+  for( b = 0; b < 2; b++ )
+    if( (b != scope_ready) && (b != scope_busy) )
+      return b;
+
+  return -1;
+}
+
+static void ets_cb(ADCDriver *adcp, adcsample_t *buffer, size_t n) {
+  (void) adcp;
+  (void) n;
+
+  ets_timer_disable();
+
+  if( ets_target >= 0 )
+    scope_bufs[ets_target][ets_slot] = buffer[0];
+  ets_slot++;
+  if( ets_slot >= SCOPE_SAMPLE_DEPTH ) {
+    osalSysLockFromISR();
+    if( ets_target >= 0 ) {
+      scope_ready = ets_target;
+      if( cmp_init )
+        chEvtBroadcastI(&cmp_event);
+    }
+    ets_target = ets_free_buffer();
+    osalSysUnlockFromISR();
+
+    ets_slot = 0;
+  }
+
+  ets_timer_arm(ets_slot);
+}
+
+static const ADCConversionGroup etsadc = {
+    1, // circular over two samples, so every conversion reaches a callback
+    1, // just one channel
+    ets_cb,  // callback
+    NULL,  // error callback
+    1 << 4, // channel 4
+    // CFG1 register, same as the real-time timebases
+    ADCx_CFG1_ADIV(ADCx_CFG1_ADIV_DIV_2) |
+    ADCx_CFG1_ADICLK(ADCx_CFG1_ADIVCLK_BUS_CLOCK_DIV_2) |
+    ADCx_CFG1_MODE(ADCx_CFG1_MODE_12_OR_13_BITS) | 0x10,
+
+    // SC3 register
+    0, // one conversion per trigger
+
+    // SOPT7: the TPM1 overflow, one per comparator edge
+    ADC_SOPT7_TRIGGER(SIM_SOPT7_ADC0TRGSEL_TPM1)
+  };
+
+static void ets_start(void) {
+
+  ets_slot = 0;
+  ets_target = 0;
+
+  adcStartConversion(&ADCD1, &etsadc, ets_sample, 2);
+
+  pwmStart(&PWMD2, &scope_timer_config);
+  ets_timer_disable();
+  triggerStartTimer();
+  PWMD2.tpm->CONF = TPM_CONF_TRGSEL(ETS_TRGSEL_CMP0) | TPM_CONF_CSOT | TPM_CONF_CSOO;
+  ets_timer_arm(0);
+}
+
+void scopeStart(void) {
+
+  scope_busy = -1;
+  scope_ready = -1;
+  scope_trigger_index = -1;
+
+  adcAcquireBus(&ADCD1);
+
+  if( scope_timebase == SCOPE_TIMEBASE_ETS ) {
+    ets_start();
+  }
+  else {
+    adcStartConversion(&ADCD1,
+                       &lightadc,
+                       scope_sample,
+                       SCOPE_RING_DEPTH);
+
+    // the ADC is armed, so the very first overflow already lands a sample
+    pwmStart(&PWMD2, &scope_timer_config);
+    pwmChangePeriod(&PWMD2, scope_timer_period());
+    triggerStart();
+  }
+  scope_running = 1;
+}
+
+void scopeStop(void) {
+
+  scope_running = 0;
+  triggerStop();
+  PWMD2.tpm->CONF = 0;
+  pwmStop(&PWMD2);
+  adcStopConversion(&ADCD1);
+  adcReleaseBus(&ADCD1);
+}
+
+// step to the next slower timebase; after the slowest comes equivalent time, then the fastest
+uint8_t scopeNextTimebase(void) {
+  uint8_t was_ets = scope_timebase == SCOPE_TIMEBASE_ETS;
+
+  scope_timebase++;
+  if( scope_timebase > SCOPE_TIMEBASE_ETS )
+    scope_timebase = 0;
+
+  if( scope_running ) {
+    // equivalent time runs the ADC and timer quite differently, start over
+    if( was_ets || (scope_timebase == SCOPE_TIMEBASE_ETS) ) {
+      scopeStop();
+      scopeStart();
+    }
+    else {
+      pwmChangePeriod(&PWMD2, scope_timer_period());
+    }
+  }
+
+  return scope_timebase;
+}
+
+// timer counts between samples, or between equivalent time slots, as programmed
+uint32_t scopeGetSampleCounts(void) {
+
+  if( scope_timebase == SCOPE_TIMEBASE_ETS )
+    return ETS_STEP_COUNTS;
 
-void scopeReadI(void) {
+  return scope_timer_period();
+}
 
-  if( ADCD1.state != ADC_ACTIVE )
-    adcStartConversionI(&ADCD1,
-			&lightadc,
-			scope_sample,
-			SCOPE_SAMPLE_DEPTH);
+// nanoseconds between samples, rounded from the counts actually programmed
+uint32_t scopeGetSampleNs(void) {
 
-  return;
+  return (uint32_t) (((uint64_t) scopeGetSampleCounts() * 1000000000UL + SCOPE_TIMER_HZ / 2) /
+                     SCOPE_TIMER_HZ);
+}
+
+// true when frames are assembled over many triggers rather than captured in one go
+bool scopeIsEquivalentTime(void) {
+
+  return scope_timebase == SCOPE_TIMEBASE_ETS;
+}
+
+// stamp the trigger against the ADC write position; false if a capture is already pending
+bool scopeTriggerI(void) {
+
+  if( !scope_running || (scope_trigger_index >= 0) )
+    return false;
+
+  scope_trigger_index = ADCD1.current_index & (SCOPE_RING_DEPTH - 1);
+  return true;
+}
+
+// take the newest complete frame, NULL if none; it's ours until scopeReleaseFrame()
+adcsample_t *scopeGetFrame(void) {
+  adcsample_t *frame = NULL;
+
+  osalSysLock();
+  if( scope_ready >= 0 ) {
+    scope_busy = scope_ready;
+    scope_ready = -1;
+    frame = scope_bufs[scope_busy];
+  }
+  osalSysUnlock();
+
+  return frame;
+}
+
+void scopeReleaseFrame(void) {
+
+  scope_busy = -1;
+}
+
+// percent of the window shown before the trigger point
+void scopeSetPretrigger(uint8_t percent) {
+
+  if( percent > 100 )
+    percent = 100;
+
+  osalSysLock();
+  scope_pretrigger = (SCOPE_SAMPLE_DEPTH * percent) / 100;
+  osalSysUnlock();
+}
+
+// number of samples in a frame that precede the trigger
+uint16_t scopeGetPretrigger(void) {
+
+  if( scope_timebase == SCOPE_TIMEBASE_ETS )
+    return 0;  // slot 0 is the trigger itself
+  return scope_pretrigger;
 }
 
 uint16_t *scopeRead(int adc_num, int speed_mode) {
@@ -103,7 +391,7 @@ uint16_t *scopeRead(int adc_num, int speed_mode) {
     0 // 1 sample
     :
     ADCx_SC3_AVGE |
-    ADCx_SC3_AVGS(ADCx_SC3_AVGS_AVERAGE_8_SAMPLES) 
+    ADCx_SC3_AVGS(ADCx_SC3_AVGS_AVERAGE_8_SAMPLES),
 
     //      48 MHz sysclk
     // /2   24 MHz busclk
@@ -111,6 +399,8 @@ uint16_t *scopeRead(int adc_num, int speed_mode) {
     // /2   6 MHz after adiv
     // /17  353ksps after base sample time @ 12 bps
     // /1   353ksps with no averaging
+
+    0 // SOPT7: software triggered
   };
 
   result = adcConvert(&ADCD1,
@@ -123,10 +413,6 @@ uint16_t *scopeRead(int adc_num, int speed_mode) {
   return (uint16_t *)scope_sample;
 }
 
-void analogStart() {
-  ADCD1.adc->CFG2 = 0x7;  // dial in the sample time to be just right for the PWM demo
-}
-
 uint32_t analogRead(int adc_num) {
   msg_t result;
   adcsample_t sample;
@@ -154,7 +440,7 @@ uint32_t analogRead(int adc_num) {
 
     // SC3 register
     ADCx_SC3_AVGE |
-    ADCx_SC3_AVGS(ADCx_SC3_AVGS_AVERAGE_32_SAMPLES) // 32 sample average
+    ADCx_SC3_AVGS(ADCx_SC3_AVGS_AVERAGE_32_SAMPLES), // 32 sample average
 
     //      48 MHz sysclk
     // /2   24 MHz busclk
@@ -162,6 +448,8 @@ uint32_t analogRead(int adc_num) {
     // /2   6 MHz after adiv
     // /20  300ksps after base sample time @ 12 bps
     // /32  9.375ksps after averaging by factor of 32
+
+    0 // SOPT7: software triggered
   };
 
   result = adcConvert(&ADCD1,
@@ -174,3 +462,61 @@ uint32_t analogRead(int adc_num) {
   return (uint32_t) sample;
 }
 
+/*
+  Convert every channel in channel_mask, depth times over, in one started
+  conversion. Results land a row at a time in ascending channel order, so
+  channels sharing a scan see the same conditions rather than drifting apart
+  between separate reads.
+ */
+msg_t analogScan(uint32_t channel_mask, adcsample_t *samples, size_t depth) {
+  adc_channels_num_t channels = 0;
+  uint32_t mask;
+
+  for( mask = channel_mask; mask != 0; mask &= mask - 1 )
+    channels++;
+
+  ADCConversionGroup scangrp = {
+    0, // circular buffer mode? no.
+    channels,
+    NULL,  // callback
+    NULL,  // error callback
+    channel_mask,
+    // CFG1 register, same clocking as analogRead()
+    ADCx_CFG1_ADIV(ADCx_CFG1_ADIV_DIV_2) |
+    ADCx_CFG1_ADICLK(ADCx_CFG1_ADIVCLK_BUS_CLOCK_DIV_2) |
+    ADCx_CFG1_MODE(ADCx_CFG1_MODE_12_OR_13_BITS),  // 12 bits per sample
+
+    // SC3 register
+    ADCx_SC3_AVGE |
+    ADCx_SC3_AVGS(ADCx_SC3_AVGS_AVERAGE_4_SAMPLES), // rows do the rest of the averaging
+
+    0 // SOPT7: software triggered
+  };
+
+  return adcConvert(&ADCD1, &scangrp, samples, depth);
+}
+
+/*
+  Input voltage against the 1.0V bandgap, both from the same interleaved
+  scan, with the ratio taken once over the whole batch. Four rows of 4x
+  hardware averaging is half the conversions of two 32x averaged reads.
+ */
+uint32_t analogReadMillivolts(int adc_num) {
+  adcsample_t samples[ANALOG_SCAN_DEPTH * 2];
+  uint32_t input = 0;
+  uint32_t bandgap = 0;
+  int i;
+
+  if( analogScan((1 << adc_num) | ADC_BANDGAP, samples, ANALOG_SCAN_DEPTH) != MSG_OK )
+    return 0;
+
+  // the bandgap is channel 27, above any pin, so it's second in each row
+  for( i = 0; i < ANALOG_SCAN_DEPTH; i++ ) {
+    input += samples[i * 2];
+    bandgap += samples[i * 2 + 1];
+  }
+  if( bandgap == 0 )
+    return 0;
+
+  return (input * 1000) / bandgap;
+}
@@ -1,4 +1,9 @@
-#define SCOPE_SAMPLE_DEPTH  128
+#define SCOPE_SAMPLE_DEPTH  128                    // may exceed the screen width, draw_wave() decimates
+#define SCOPE_RING_DEPTH    (2 * SCOPE_SAMPLE_DEPTH)  // must be a power of two
+#define SCOPE_PRETRIGGER_DEFAULT  25                   // percent of the frame before the trigger
+#define SCOPE_TIMEBASE_DEFAULT    3                    // index into the timebase table, 100us per sample
+#define ANALOG_SCAN_DEPTH         4                    // rows per analogReadMillivolts() scan
+#define SCOPE_TIMER_HZ            KINETIS_SYSCLK_FREQUENCY // TPM1 paces the samples, undivided
 
 void analogUpdateTemperature(void);
 int32_t analogReadTemperature(void);
@@ -6,7 +11,19 @@ int32_t analogReadTemperature(void);
 void analogUpdateMic(void);
 uint8_t *analogReadMic(void);
 
-void analogStart(void);
 uint32_t analogRead(int adc_num);
+msg_t analogScan(uint32_t channel_mask, adcsample_t *samples, size_t depth);
+uint32_t analogReadMillivolts(int adc_num);
 uint16_t *scopeRead(int adc_num, int speed_mode);
-void scopeReadI(void);
+
+void scopeStart(void);
+void scopeStop(void);
+bool scopeTriggerI(void);
+adcsample_t *scopeGetFrame(void);
+void scopeReleaseFrame(void);
+void scopeSetPretrigger(uint8_t percent);
+uint16_t scopeGetPretrigger(void);
+uint8_t scopeNextTimebase(void);
+uint32_t scopeGetSampleCounts(void);
+uint32_t scopeGetSampleNs(void);
+bool scopeIsEquivalentTime(void);
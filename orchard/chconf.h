@@ -46,7 +46,7 @@
  * @details Frequency of the system timer that drives the system ticks. This
  *          setting also defines the system tick time unit.
  */
-#define CH_CFG_ST_FREQUENCY                 1000
+#define CH_CFG_ST_FREQUENCY                 32768
 
 /**
  * @brief   Time delta constant for the tick-less mode.
@@ -56,7 +56,7 @@
  *          The value one is not valid, timeouts are rounded up to
  *          this value.
  */
-#define CH_CFG_ST_TIMEDELTA                 0
+#define CH_CFG_ST_TIMEDELTA                 2
 
 /** @} */
 
@@ -79,7 +79,7 @@
  * @note    The round robin preemption is not supported in tickless mode and
  *          must be set to zero in that case.
  */
-#define CH_CFG_TIME_QUANTUM                 20
+#define CH_CFG_TIME_QUANTUM                 0
 
 /**
  * @brief   Managed RAM size.
@@ -100,7 +100,14 @@
  *          does not spawn the idle thread. The application @p main()
  *          function becomes the idle thread and must implement an
  *          infinite loop. */
-#define CH_CFG_NO_IDLE_THREAD               TRUE
+#define CH_CFG_NO_IDLE_THREAD               FALSE
+
+/**
+ * @brief   Idle thread sleeps in WFI, which is WAIT mode on the KL02.
+ * @note    VLPS would also stop the bus clock, and with it the UART, the
+ *          LED PWM and the sampling timer, one of which is always in use.
+ */
+#define CORTEX_ENABLE_WFI_IDLE              TRUE
 
 /** @} */
 
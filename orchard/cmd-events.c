@@ -0,0 +1,47 @@
+/*
+    ChibiOS/RT - Copyright (C) 2006-2013 Giovanni Di Sirio
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+        http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+#include "ch.h"
+#include "shell.h"
+#include "chprintf.h"
+#include <string.h>
+
+#include "orchard-shell.h"
+#include "orchard-events.h"
+
+extern struct evt_table orchard_app_events;
+
+static void cmd_events(BaseSequentialStream *chp, int argc, char *argv[])
+{
+  struct evt_table *table = &orchard_app_events;
+  int i;
+
+  (void)argv;
+  if (argc > 1 || (argc == 1 && strcmp(argv[0], "clear"))) {
+    chprintf(chp, "Usage: events [clear]\r\n");
+    return;
+  }
+
+  if (argc == 1) {
+    for (i = 0; i < table->next; i++)
+      memset(&table->stats[i], 0, sizeof(table->stats[i]));
+    return;
+  }
+
+  evtTablePrintStats(chp, table);
+}
+
+orchard_command("events", cmd_events);
@@ -22,17 +22,18 @@
 
 void cmd_mem(BaseSequentialStream *chp, int argc, char *argv[])
 {
-  size_t n, size;
+  size_t n, size, largest;
 
   (void)argv;
   if (argc > 0) {
     chprintf(chp, "Usage: mem\r\n");
     return;
   }
-  n = chHeapStatus(NULL, &size);
+  n = chHeapStatus(NULL, &size, &largest);
   chprintf(chp, "core free memory : %u bytes\r\n", chCoreGetStatusX());
   chprintf(chp, "heap fragments   : %u\r\n", n);
   chprintf(chp, "heap free total  : %u bytes\r\n", size);
+  chprintf(chp, "heap largest free: %u bytes\r\n", largest);
 }
 
 orchard_command("mem", cmd_mem);
@@ -0,0 +1,112 @@
+/*
+    ChibiOS/RT - Copyright (C) 2006-2013 Giovanni Di Sirio
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+        http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+#include "ch.h"
+#include "shell.h"
+#include "chprintf.h"
+#include <stdlib.h>
+#include <string.h>
+
+#include "orchard-shell.h"
+#include "trigger.h"
+
+static int find_name(const char *(*name_of)(int), int count, const char *name)
+{
+  int i;
+
+  for (i = 0; i < count; i++) {
+    if (!strcmp(name_of(i), name))
+      return i;
+  }
+  return -1;
+}
+
+static const char *edge_name(int i)
+{
+  return triggerEdgeName((trigger_edge)i);
+}
+
+static const char *mode_name(int i)
+{
+  return triggerModeName((trigger_mode)i);
+}
+
+static void usage(BaseSequentialStream *chp)
+{
+  chprintf(chp, "Usage: trigger [edge rising|falling|both]\r\n");
+  chprintf(chp, "               [mode auto|normal|single]\r\n");
+  chprintf(chp, "               [level 0-63] [holdoff ms] [arm]\r\n");
+}
+
+static void cmd_trigger(BaseSequentialStream *chp, int argc, char *argv[])
+{
+  char *end;
+  unsigned long val;
+  int i;
+
+  if (argc == 0) {
+    triggerPrintSettings(chp);
+    return;
+  }
+
+  if (argc == 1 && !strcmp(argv[0], "arm")) {
+    triggerArm();
+    return;
+  }
+
+  if (argc != 2) {
+    usage(chp);
+    return;
+  }
+
+  if (!strcmp(argv[0], "edge")) {
+    i = find_name(edge_name, 3, argv[1]);
+    if (i < 0) {
+      usage(chp);
+      return;
+    }
+    triggerSetEdge((trigger_edge)i);
+  }
+  else if (!strcmp(argv[0], "mode")) {
+    i = find_name(mode_name, 3, argv[1]);
+    if (i < 0) {
+      usage(chp);
+      return;
+    }
+    triggerSetMode((trigger_mode)i);
+  }
+  else if (!strcmp(argv[0], "level")) {
+    val = strtoul(argv[1], &end, 0);
+    if (*end || val > 63) {
+      usage(chp);
+      return;
+    }
+    triggerSetThreshold(val);
+  }
+  else if (!strcmp(argv[0], "holdoff")) {
+    val = strtoul(argv[1], &end, 0);
+    if (*end || val > 0xFFFF) {
+      usage(chp);
+      return;
+    }
+    triggerSetHoldoff(val);
+  }
+  else {
+    usage(chp);
+  }
+}
+
+orchard_command("trigger", cmd_trigger);
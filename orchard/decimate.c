@@ -0,0 +1,102 @@
+#include <stdint.h>
+
+#include "decimate.h"
+
+/*
+  Waveform scaling and min/max decimation.
+
+  This has no ChibiOS or uGFX dependencies so it can be built and poked at
+  on a host. The M0+ has no divide instruction, so the two divides we need
+  (vertical scale and horizontal step) are done once per frame and turned
+  into 16.16 fixed-point factors; the per-sample work is compare, multiply
+  and shift.
+
+  Vertical scaling matches what draw_wave() always did: the trace is scaled
+  by height / max and centered, so a small swing on a large DC level still
+  looks small.
+
+  When nsamples >= ncols, cols may alias samples: column c is only written
+  after every sample it covers has been read, and it overlaps sample c,
+  which has already been consumed.
+ */
+
+static uint8_t to_row(uint16_t s, uint16_t min, uint32_t recip,
+                      uint16_t offset, uint16_t height) {
+  uint32_t y;
+
+  // (s - min) <= max, so the product never exceeds height << 16
+  y = (((uint32_t)(s - min) * recip) >> 16) + offset;
+  if( y > (uint32_t)(height - 1) )
+    y = height - 1;
+
+  return (uint8_t) y;
+}
+
+void decimateMinMax(const uint16_t *samples, uint16_t nsamples,
+                    wave_span_t *cols, uint16_t ncols, uint16_t height) {
+  uint16_t min, max, lo, hi, s, offset;
+  uint32_t recip, step, pos, span;
+  uint16_t c, i, end;
+  uint8_t lo_y, hi_y, prev_lo = 0, prev_hi = 0;
+
+  if( (nsamples == 0) || (ncols == 0) || (height == 0) )
+    return;
+
+  min = 0xFFFF, max = 0x0;
+  for( i = 0; i < nsamples; i++ ) {
+    if( samples[i] > max )
+      max = samples[i];
+    if( samples[i] < min )
+      min = samples[i];
+  }
+
+  if( max == 0 )
+    max = 1;  // to avoid divide by zero
+
+  recip = ((uint32_t) height << 16) / max;
+  span = ((uint32_t)(max - min) * recip) >> 16;
+  if( span < height )
+    offset = (height - span) / 2;
+  else
+    offset = 0;
+
+  // samples per column in 16.16; below 1.0 columns repeat the nearest sample
+  step = ((uint32_t) nsamples << 16) / ncols;
+
+  pos = 0;
+  for( c = 0; c < ncols; c++ ) {
+    i = pos >> 16;
+    pos += step;
+    end = pos >> 16;
+    if( end > nsamples )
+      end = nsamples;
+    if( i >= nsamples )
+      i = nsamples - 1;
+
+    lo = hi = samples[i];
+    for( i++; i < end; i++ ) {
+      s = samples[i];
+      if( s < lo )
+        lo = s;
+      if( s > hi )
+        hi = s;
+    }
+
+    lo_y = to_row(lo, min, recip, offset, height);
+    hi_y = to_row(hi, min, recip, offset, height);
+
+    cols[c].lo = lo_y;
+    cols[c].hi = hi_y;
+
+    // stretch toward the previous column so the trace stays connected
+    if( c > 0 ) {
+      if( lo_y > prev_hi )
+        cols[c].lo = prev_hi;
+      if( hi_y < prev_lo )
+        cols[c].hi = prev_lo;
+    }
+
+    prev_lo = lo_y;
+    prev_hi = hi_y;
+  }
+}
@@ -0,0 +1,17 @@
+#ifndef __DECIMATE_H__
+#define __DECIMATE_H__
+
+#include <stdint.h>
+
+/* One screen column of a decimated waveform, as rows counted up from the
+   bottom of the screen. lo..hi is the envelope of every sample that landed
+   in the column, widened so it touches the previous column. */
+typedef struct {
+  uint8_t lo;
+  uint8_t hi;
+} wave_span_t;
+
+void decimateMinMax(const uint16_t *samples, uint16_t nsamples,
+                    wave_span_t *cols, uint16_t ncols, uint16_t height);
+
+#endif /* __DECIMATE_H__ */
@@ -8,25 +8,46 @@
 #include "gfx.h"
 
 #include "dv-serialmode.h"
+#include "analog.h"
+#include "stream.h"
+#include "trigger.h"
+
+#include <string.h>
 
-#define SENTINAL_LEN 5
-static uint8_t lockon_pos = 0;
-static uint8_t lockoff_pos = 0;
 uint8_t locker_mode = 0;
-static uint8_t sentinal_pos = 0;
-static uint8_t firmware_pos = 0;
-static char lockon[] = "#LCK\n";
-static char lockoff[] = "#RUN\n";
-static char sentinal[] = "#SYN\n";
-static char firmware[] = "#VER\n";
+extern uint8_t current_mode;
+extern struct evt_table orchard_app_events;
 
 #define MAX_COLS 18
 #define MAX_ROWS 5
-// the extra max_rows is to accommodate newlines on each line which don't print but take space
-#define TEXT_LEN ((MAX_COLS * MAX_ROWS) + SENTINAL_LEN + MAX_ROWS + 1) 
+// enough for every visible line to stay intact, plus a line being built
+#define TEXT_LEN ((MAX_ROWS + 1) * MAX_COLS)
 static char text_buffer[TEXT_LEN];
 static int16_t write_ptr = 0; 
 
+/*
+  Line index, maintained as characters arrive so a redraw only touches the
+  lines on screen. Each entry is one screen row: where it starts in
+  text_buffer and how many characters it holds. The newest entry is the
+  line currently being written.
+ */
+#define LINE_SLOTS 8  // power of two, > MAX_ROWS so a command can be backed out
+struct text_line {
+  int16_t start;
+  uint8_t len;
+  uint8_t wrapped;   // started by running out of columns, not by a newline
+};
+static struct text_line lines[LINE_SLOTS];
+static uint8_t line_head = 0;   // index of the line being written
+static uint8_t line_count = 1;  // valid entries, saturates at LINE_SLOTS
+
+/*
+  The dispatcher writes the ring while the Redraw worker draws it, so both
+  hold text_mutex around it. The drawer only keeps it long enough to copy
+  out the rows on screen, the slow part runs without it.
+ */
+static MUTEX_DECL(text_mutex);
+
 extern uint32_t serial_needs_update;
 systime_t last_update_time = 0;
 
@@ -34,260 +55,382 @@ uint8_t isprint_local(char c) {
   return ((c >= ' ' && c <= '~') ? 1 : 0);
 }
 
-int find_printable_window(void) {
-  int chars_searched = 0;
-  int num_lines = 0;
-  int cur_ptr = write_ptr;
-  int chars_since_newline = 0;
-  int chars_since_hard_newline = 0;
-
-  // starting from the last written character, search backwards...
-  while( chars_searched < TEXT_LEN ) {
-    if( text_buffer[cur_ptr] == '\n' ) {
-      //      chprintf(stream, "n");
-      num_lines++;
-      // MAX_ROWS+1 if you want to show the current incoming line too
-      // MAX_ROWS+2 if you only want to show fully formed lines
-      if( num_lines == (MAX_ROWS) ) { // forward back over the final newline we found
-	cur_ptr++; cur_ptr %= TEXT_LEN;
-      	break;
-      }
-      chars_since_newline = 0;
-      chars_since_hard_newline = 0;
-      chars_searched++;
+static void dv_new_line(uint8_t wrapped) {
+  line_head = (line_head + 1) & (LINE_SLOTS - 1);
+  lines[line_head].start = write_ptr;
+  lines[line_head].len = 0;
+  lines[line_head].wrapped = wrapped;
+  if( line_count < LINE_SLOTS )
+    line_count++;
+}
 
-      cur_ptr--;
-      if( cur_ptr < 0 )
-	cur_ptr = TEXT_LEN - 1;
-      continue;
-    }
+static void dv_put_char(char c) {
+  struct text_line *line = &lines[line_head];
 
-    if( chars_since_newline >= (MAX_COLS) ) {
-      //      chprintf(stream, "c");
-      num_lines++; // don't count lines that are exactly the width of the screen + a newline
-      // MAX_ROWS+1 if you want to show the current incoming line too
-      // MAX_ROWS+2 if you only want to show fully formed lines
-      if( (
-	   (num_lines == (MAX_ROWS-1)) &&
-	   (chars_since_hard_newline <= (MAX_COLS * (MAX_ROWS-1) -1 ) )
-	   ) ||
-	  (num_lines == MAX_ROWS) ) {
-	// cur_ptr++; cur_ptr %= TEXT_LEN; // comment out because we didn't end on a newline, so don't eat
-	break;
-      }
-      chars_since_newline = 0;
+  if( c == '\n' ) {
+    // if CRLF, eat multiple CRLF
+    if( (line->len == 0) && !line->wrapped )
+      return;
+    dv_new_line(0);
+    if( !locker_mode ) {
+      last_update_time = chVTGetSystemTime();
+      serial_needs_update = 1; // update on CR
     }
-    cur_ptr--;
-    if( cur_ptr < 0 )
-      cur_ptr = TEXT_LEN - 1;
-    chars_searched++;
-    chars_since_newline++;
-    chars_since_hard_newline++;
+    return;
+  }
+
+  // wrap lazily, so a line exactly as wide as the screen plus a newline is one row
+  if( line->len == MAX_COLS ) {
+    dv_new_line(1);
+    line = &lines[line_head];
   }
 
-  // this happens when there are no new lines at all, and the buffer just wraps around
-  if( cur_ptr == write_ptr ) {
-    //    chprintf(stream, "x");
-    cur_ptr = write_ptr + 1;
-    cur_ptr %= TEXT_LEN;
+  text_buffer[write_ptr] = isprint_local(c) ? c : '.';
+  write_ptr++;
+  if( write_ptr == TEXT_LEN )
+    write_ptr = 0;
+  line->len++;
+}
+
+// back out the last n characters, e.g. a command sequence that was echoed into the buffer
+// called with text_mutex held, as is dv_put_char()
+static void dv_unput_chars(int n) {
+  struct text_line *line;
+
+  while( n > 0 ) {
+    line = &lines[line_head];
+    if( line->len == 0 ) {
+      // only step back over wraps, a newline ends the characters we can take back
+      if( !line->wrapped || (line_count <= 1) )
+        return;
+      line_head = (line_head - 1) & (LINE_SLOTS - 1);
+      line_count--;
+      continue;
+    }
+    line->len--;
+    write_ptr--;
+    if( write_ptr < 0 )
+      write_ptr = TEXT_LEN - 1;
+    n--;
   }
-  //  chprintf(stream, "\n\r");
-  
-  return cur_ptr;
 }
 
 void updateSerialScreen(void) {
-  coord_t width;
   coord_t font_height;
+  coord_t char_width;
   font_t font;
-  int cur_char;
-  int i;
-  int chars_processed;
-  int render_line = 0;
-  char str_to_render[MAX_COLS + 1];
+  struct text_line *line;
+  char screen[MAX_ROWS][MAX_COLS];
+  uint8_t lens[MAX_ROWS];
+  int16_t pos;
+  uint8_t rows, row, i;
+
+  // snapshot the rows on screen, so the writer is only held up for the copy
+  chMtxLock(&text_mutex);
+  rows = (line_count < MAX_ROWS) ? line_count : MAX_ROWS;
+  for( row = 0; row < rows; row++ ) {
+    line = &lines[(line_head - (rows - 1) + row) & (LINE_SLOTS - 1)];
+    lens[row] = line->len;
+    pos = line->start;
+    for( i = 0; i < line->len; i++ ) {
+      screen[row][i] = text_buffer[pos];
+      pos++;
+      if( pos == TEXT_LEN )
+	pos = 0;
+    }
+  }
+  chMtxUnlock(&text_mutex);
 
   orchardGfxStart();
   font = gdispOpenFont("fixed_7x14");
-  width = gdispGetWidth();
-  //  height = gdispGetHeight();
-
   font_height = gdispGetFontMetric(font, fontHeight);
+  char_width = gdispGetCharWidth('M', font);  // fixed width font
 
   gdispClear(Black);
-  chars_processed = 0;
-  cur_char = find_printable_window();
-  while( (chars_processed < TEXT_LEN) && (render_line <= MAX_ROWS) ) {
-    // copy text starting at last newline into local render buffer
-    i = 0;
-    while( i < MAX_COLS ) {
-      if( cur_char == write_ptr )
-	break;
-
-      if( text_buffer[cur_char] == '\n'  ) {
-	str_to_render[i] = '\0';  // don't use a space for newline so we can go to edge of screen
-	cur_char++; i++; chars_processed++;
-	cur_char %= TEXT_LEN;
-	break;
-      }
-      if( isprint_local(text_buffer[cur_char]) )
-	str_to_render[i] = text_buffer[cur_char];
-      else
-	str_to_render[i] = '.';
-      cur_char++; i++; chars_processed++;
-      cur_char %= TEXT_LEN;
-    }
-    str_to_render[i] = '\0';
-    //    chprintf(stream, "%s\n\r", str_to_render);
-    gdispDrawStringBox(0, render_line * font_height, width, gdispGetFontMetric(font, fontHeight),
-		       (const char *) str_to_render, font, White, justifyLeft);
-
-#if 0
-    if( (i == MAX_COLS) && (text_buffer[cur_char] == '\n') ) {
-      // in this case, we printed a full line, with a newline just at the end. eat the newline, don't print it.
-      cur_char++; chars_processed++;
-      cur_char %= TEXT_LEN; // i gets reset on the next iter
-    }
-#endif
-    render_line++;
 
-    if( cur_char == write_ptr )
-      break;
+  for( row = 0; row < rows; row++ ) {
+    for( i = 0; i < lens[row]; i++ )
+      gdispDrawChar(i * char_width, row * font_height, screen[row][i], font, White);
   }
+
   gdispFlush();
   gdispCloseFont(font);
   orchardGfxEnd();
 }
 
 void dvInit(void) {
-  int i;
   last_update_time = chVTGetSystemTime();
-  for( i = 0; i < TEXT_LEN; i++ ) {
-    text_buffer[i] = '\n'; // init with CR's
-  }
-  text_buffer[TEXT_LEN-1] = '\n'; // simulate final newline
+  chMtxLock(&text_mutex);
   write_ptr = 0;
+  line_head = 0;
+  line_count = 1;
+  lines[0].start = 0;
+  lines[0].len = 0;
+  lines[0].wrapped = 0;
+  chMtxUnlock(&text_mutex);
 }
 
-uint32_t dv_search_sentinal(char c) {
-  if( c == sentinal[sentinal_pos] && (sentinal_pos == (SENTINAL_LEN - 1)) ) {
-    sentinal_pos = 0;
-    return 1;
-  }
-  if( c == sentinal[sentinal_pos] ) {
-    sentinal_pos++;
-    return 0;
-  }
-  
-  sentinal_pos = 0;
-  return 0;
+/*
+  In-band commands. All of them are recognised in a single pass over the
+  incoming bytes by an Aho-Corasick automaton built from this table, so
+  adding a command is just adding a row here.
+ */
+struct dv_command {
+  const char *seq;
+  void (*handler)(const struct dv_command *cmd);
+  uint8_t any_mode;  // also honoured outside serial mode, where text is dropped
+};
+
+// eat a sequence echoed into the buffer, bar the newline which never made it in
+static void dv_unput_seq(const struct dv_command *cmd) {
+
+  if( current_mode != MODE_SERIAL )
+    return;  // nothing is buffered in the other modes
+
+  chMtxLock(&text_mutex);
+  dv_unput_chars(strlen(cmd->seq) - 1);
+  chMtxUnlock(&text_mutex);
 }
 
-uint32_t dv_search_lockoff(char c) {
-  if( c == lockoff[lockoff_pos] && (lockoff_pos == (SENTINAL_LEN - 1)) ) {
-    lockoff_pos = 0;
-    return 1;
-  }
-  if( c == lockoff[lockoff_pos] ) {
-    lockoff_pos++;
-    return 0;
-  }
-  
-  lockoff_pos = 0;
-  return 0;
+// render the buffer to screen and clear it
+static void dv_cmd_sync(const struct dv_command *cmd) {
+  dv_unput_seq(cmd);
+  last_update_time = chVTGetSystemTime();
+  updateSerialScreen();
+  dvInit();
+}
+
+static void dv_cmd_lockon(const struct dv_command *cmd) {
+  (void)cmd;
+  locker_mode = 1;
+  dvInit();
+}
+
+static void dv_cmd_lockoff(const struct dv_command *cmd) {
+  (void)cmd;
+  locker_mode = 0;
+  dvInit();
 }
 
-uint32_t dv_search_lockon(char c) {
-  if( c == lockon[lockon_pos] && (lockon_pos == (SENTINAL_LEN - 1)) ) {
-    lockon_pos = 0;
-    return 1;
+static void dv_cmd_firmware(const struct dv_command *cmd) {
+  char vers[11];
+
+  (void)cmd;
+  chsnprintf(vers, sizeof(vers), "%s", gitversion );
+  oledPauseBanner(vers);
+  chThdSleepMilliseconds(4500);
+  dvInit();
+  last_update_time = chVTGetSystemTime();
+  updateSerialScreen();
+}
+
+// binary capture frames from wave mode, the link switches to STREAM_BAUD
+static void dv_cmd_stream_on(const struct dv_command *cmd) {
+  dv_unput_seq(cmd);
+  streamStart();
+}
+
+static void dv_cmd_stream_off(const struct dv_command *cmd) {
+  dv_unput_seq(cmd);
+  streamStop();
+}
+
+// handler run times, sent back to the host; left out while frames are streaming
+static void dv_cmd_events(const struct dv_command *cmd) {
+  dv_unput_seq(cmd);
+  if( !streamActive() )
+    evtTablePrintStats(stream, &orchard_app_events);
+}
+
+// trigger settings, each command steps one of them and sends back the result
+static const uint16_t dv_holdoffs[] = { 0, 10, 100, 1000 };  // ms
+
+static void dv_trigger_report(const struct dv_command *cmd) {
+  dv_unput_seq(cmd);
+  if( !streamActive() )
+    triggerPrintSettings(stream);
+}
+
+static void dv_cmd_trig_edge(const struct dv_command *cmd) {
+  triggerSetEdge((trigger_edge) ((triggerGetEdge() + 1) % 3));
+  dv_trigger_report(cmd);
+}
+
+static void dv_cmd_trig_mode(const struct dv_command *cmd) {
+  triggerSetMode((trigger_mode) ((triggerGetMode() + 1) % 3));
+  dv_trigger_report(cmd);
+}
+
+static void dv_cmd_trig_up(const struct dv_command *cmd) {
+  triggerSetThreshold(triggerGetThreshold() + 1);  // clamps at the top
+  dv_trigger_report(cmd);
+}
+
+static void dv_cmd_trig_down(const struct dv_command *cmd) {
+  if( triggerGetThreshold() > 0 )
+    triggerSetThreshold(triggerGetThreshold() - 1);
+  dv_trigger_report(cmd);
+}
+
+static void dv_cmd_trig_holdoff(const struct dv_command *cmd) {
+  unsigned int i;
+
+  // the next step up from the current holdoff, back to 0 after the last
+  for( i = 0; i < sizeof(dv_holdoffs) / sizeof(dv_holdoffs[0]); i++ ) {
+    if( dv_holdoffs[i] > triggerGetHoldoff() )
+      break;
   }
-  if( c == lockon[lockon_pos] ) {
-    lockon_pos++;
-    return 0;
+  triggerSetHoldoff(i < sizeof(dv_holdoffs) / sizeof(dv_holdoffs[0]) ? dv_holdoffs[i] : 0);
+  dv_trigger_report(cmd);
+}
+
+static void dv_cmd_trig_arm(const struct dv_command *cmd) {
+  triggerArm();
+  dv_trigger_report(cmd);
+}
+
+static const struct dv_command dv_commands[] = {
+  { "#SYN\n", dv_cmd_sync, 0 },
+  { "#LCK\n", dv_cmd_lockon, 0 },
+  { "#RUN\n", dv_cmd_lockoff, 0 },
+  { "#VER\n", dv_cmd_firmware, 0 },
+  { "#STR\n", dv_cmd_stream_on, 1 },
+  { "#STP\n", dv_cmd_stream_off, 1 },
+  { "#EVT\n", dv_cmd_events, 1 },
+  { "#TRE\n", dv_cmd_trig_edge, 1 },
+  { "#TRM\n", dv_cmd_trig_mode, 1 },
+  { "#TR+\n", dv_cmd_trig_up, 1 },
+  { "#TR-\n", dv_cmd_trig_down, 1 },
+  { "#TRH\n", dv_cmd_trig_holdoff, 1 },
+  { "#TRA\n", dv_cmd_trig_arm, 1 },
+};
+#define DV_NUM_COMMANDS (sizeof(dv_commands) / sizeof(dv_commands[0]))
+#define DV_MAX_NODES 48  // at least 1 + the total length of all sequences
+
+/*
+  Trie node. Children are a sibling list since each node has only a few,
+  which keeps the table to a handful of bytes per node instead of a full
+  256 entry goto row. Node 0 is the root.
+ */
+struct dv_node {
+  char c;          // byte leading into this node
+  uint8_t child;   // first child, 0 if none
+  uint8_t sibling; // next child of the same parent, 0 if none
+  uint8_t fail;    // node for the longest proper suffix that is also a prefix
+  int8_t cmd;      // index into dv_commands if a sequence ends here, else -1
+};
+static struct dv_node dv_nodes[DV_MAX_NODES];
+static uint8_t dv_node_count = 0;
+static uint8_t dv_state = 0;
+
+static uint8_t dv_find_child(uint8_t node, char c) {
+  uint8_t n;
+
+  for( n = dv_nodes[node].child; n != 0; n = dv_nodes[n].sibling ) {
+    if( dv_nodes[n].c == c )
+      return n;
   }
-  
-  lockon_pos = 0;
   return 0;
 }
 
-uint32_t dv_search_firmware(char c) {
-  if( c == firmware[firmware_pos] && (firmware_pos == (SENTINAL_LEN - 1)) ) {
-    firmware_pos = 0;
-    return 1;
+static void dv_matcher_init(void) {
+  uint8_t queue[DV_MAX_NODES];
+  uint8_t head, tail;
+  uint8_t node, n, f;
+  unsigned int i;
+  const char *s;
+
+  memset(dv_nodes, 0, sizeof(dv_nodes));
+  dv_nodes[0].cmd = -1;
+  dv_node_count = 1;
+
+  // goto function: a plain trie of all the sequences
+  for( i = 0; i < DV_NUM_COMMANDS; i++ ) {
+    node = 0;
+    for( s = dv_commands[i].seq; *s; s++ ) {
+      n = dv_find_child(node, *s);
+      if( n == 0 ) {
+	osalDbgAssert(dv_node_count < DV_MAX_NODES, "DV_MAX_NODES too small");
+	n = dv_node_count++;
+	dv_nodes[n].c = *s;
+	dv_nodes[n].cmd = -1;
+	dv_nodes[n].sibling = dv_nodes[node].child;
+	dv_nodes[node].child = n;
+      }
+      node = n;
+    }
+    dv_nodes[node].cmd = i;
   }
-  if( c == firmware[firmware_pos] ) {
-    firmware_pos++;
-    return 0;
+
+  // failure function, breadth first so a node's fail is always resolved before its children
+  head = tail = 0;
+  for( n = dv_nodes[0].child; n != 0; n = dv_nodes[n].sibling )
+    queue[tail++] = n;  // depth one fails back to the root
+
+  while( head < tail ) {
+    node = queue[head++];
+    for( n = dv_nodes[node].child; n != 0; n = dv_nodes[n].sibling ) {
+      queue[tail++] = n;
+      f = dv_nodes[node].fail;
+      while( (f != 0) && (dv_find_child(f, dv_nodes[n].c) == 0) )
+	f = dv_nodes[f].fail;
+      dv_nodes[n].fail = dv_find_child(f, dv_nodes[n].c);
+      // a sequence that ends as a suffix of this one also matches here
+      if( dv_nodes[n].cmd < 0 )
+	dv_nodes[n].cmd = dv_nodes[dv_nodes[n].fail].cmd;
+    }
   }
-  
-  firmware_pos = 0;
-  return 0;
+
+  dv_state = 0;
 }
 
+// advance the automaton by one byte, returns the command that just completed if any
+static const struct dv_command *dv_match(char c) {
+  uint8_t next;
+
+  while( ((next = dv_find_child(dv_state, c)) == 0) && (dv_state != 0) )
+    dv_state = dv_nodes[dv_state].fail;
+  dv_state = next;
+
+  if( dv_nodes[dv_state].cmd < 0 )
+    return NULL;
+  return &dv_commands[dv_nodes[dv_state].cmd];
+}
+
+#define DV_RX_CHUNK 16
+
 void dvDoSerial(void) {
+  const struct dv_command *cmd;
+  uint8_t buf[DV_RX_CHUNK];
+  size_t n, i;
   char c;
-  int8_t prev_ptr;
-  char vers[11];
 
-  while(TRUE) {
-    prev_ptr = write_ptr - 1;
-    if( prev_ptr == -1 )
-      prev_ptr = TEXT_LEN - 1;
-    
-    if(chSequentialStreamRead((BaseSequentialStream *) stream, (uint8_t *)&c, 1) == 0)
-      return;  // we keep on running until the buffer is empty
-
-    if( c == '\r' )
-      c = '\n';
-
-    if(dv_search_sentinal(c)) {
-      // render the buffer to screen, clear the buffer, and quit if the sentinal sequence is found      
-      // eat the #SYN sentinel
-      write_ptr -= (SENTINAL_LEN - 1);
-      if( write_ptr < 0 )
-	write_ptr += TEXT_LEN;
-      // display the screen contents
-      last_update_time = chVTGetSystemTime();
-      updateSerialScreen();
-      
-      dvInit();
-      return; 
-    }
-    if(dv_search_lockon(c)) {
-      locker_mode = 1;
-      dvInit();
-      return;
-    }
-    if(dv_search_lockoff(c)) {
-      locker_mode = 0;
-      dvInit();
-      return;
-    }
-    if(dv_search_firmware(c)) {
-      chsnprintf(vers, sizeof(vers), "%s", gitversion );
-      oledPauseBanner(vers);
-      chThdSleepMilliseconds(4500);
-      dvInit();
-      last_update_time = chVTGetSystemTime();
-      updateSerialScreen();
-      return;
-    }
-    
-    // if CRLF, eat multiple CRLF
-    if( c == '\n' ) {
-      if( text_buffer[prev_ptr] == '\n' ) {
-	return;
-      }
-      if( !locker_mode ) {
-	last_update_time = chVTGetSystemTime();
-	serial_needs_update = 1; // update on CR
+  if( dv_node_count == 0 )
+    dv_matcher_init();
+
+  // the UART only signals once per burst (idle line or queue watermark), so
+  // keep on running until the queue is empty, a chunk at a time
+  while( (n = chnReadTimeout((BaseChannel *) stream, buf, sizeof(buf), TIME_IMMEDIATE)) > 0 ) {
+    chMtxLock(&text_mutex);
+    for( i = 0; i < n; i++ ) {
+      c = buf[i];
+      if( c == '\r' )
+	c = '\n';
+
+      cmd = dv_match(c);
+      if( cmd != NULL ) {
+	// handlers redraw and reset the buffer, which takes the lock again
+	if( (current_mode == MODE_SERIAL) || cmd->any_mode ) {
+	  chMtxUnlock(&text_mutex);
+	  cmd->handler(cmd);
+	  chMtxLock(&text_mutex);
+	}
+	continue;
       }
-    }
-    
-    text_buffer[write_ptr] = c;
 
-    write_ptr++;
-    write_ptr %= TEXT_LEN;
-    text_buffer[write_ptr] = ' '; // rule: current spot we're pointing to for write cannot be a newline
+      if( current_mode == MODE_SERIAL )
+	dv_put_char(c);
+    }
+    chMtxUnlock(&text_mutex);
   }
 }
@@ -62,17 +62,11 @@ static void draw_volts(uint32_t millivolts) {
 }
 
 void updateVoltsScreen(void) {
-  uint32_t voltsVal;
-  uint32_t calVal;
   int i;
   uint32_t voltAvg = 0;
 
-  // first update the sample buffer
-  calVal = analogRead(27);  // channel 27 is cal = 1.0V
-  // value returned is # of LSB = 1.0V
-  voltsVal = analogRead(0) * 1000;
-  
-  volt_buf[volt_ptr] = voltsVal / calVal;  // this is volts in mV
+  // first update the sample buffer, input and 1.0V bandgap come from one scan
+  volt_buf[volt_ptr] = analogReadMillivolts(0);  // this is volts in mV
   volt_ptr++;
   volt_ptr %= VOLT_BUF_LEN;
 
@@ -35,12 +35,15 @@
 #include "dv-serialmode.h"
 #include "dv-volts.h"
 #include "dv-oscope.h"
+#include "stream.h"
+#include "trigger.h"
 
 #include "kl02x.h"
 
 struct evt_table orchard_app_events;
+static struct evt_worker redraw_worker;
+static struct evt_worker stream_worker;
 event_source_t refresh_event;
-event_source_t serial_event;
 event_source_t mode_event;
 event_source_t option_event;
 event_source_t led_event;
@@ -69,11 +72,15 @@ static const SPIConfig spi_config = {
   /* HW dependent part.*/
   GPIOA,
   5,
+  KINETIS_SPI_XFER_POLLED, // OLED commands are polled, page data stays on the IRQ so the ADC keeps running
+  0,                       // default polled length limit
 };
 
 static const ADCConfig adccfg1 = {
   /* Perform initial calibration */
-  true
+  true,
+  /* CFG2: dial in the sample time to be just right for the PWM demo */
+  0x7
 };
 
 static const EXTConfig ext_config = {
@@ -168,14 +175,7 @@ static void refresh_handler(eventid_t id) {
     updateVoltsScreen();
     break;
   case MODE_OSCOPE:
-    if( chVTTimeElapsedSinceX( last_trigger_time ) > AUTOSAMPLE_HOLDOFF_ST ) {
-      adcAcquireBus(&ADCD1);      
-      osalSysLock();
-      scopeReadI();
-      osalSysUnlock();
-      adcReleaseBus(&ADCD1);
-    }
-    // add code to enable auto-sampling if trigger has not been found for a while
+    triggerPoll();  // auto mode forces a capture when nothing has triggered for a while
     // updateOscopeScreen(); // now handled by trigger mechanism
     break;
   default:
@@ -184,25 +184,29 @@ static void refresh_handler(eventid_t id) {
 }
 
 static void option_handler(eventid_t id) {
+  char banner[16];
   (void) id;
   
   switch(current_mode) {
   case MODE_SERIAL:
     serial_init = serial_init ? 0 : 1;  // "scroll lock"
-    if( !serial_init  )
+    if( !serial_init  ) {
       oledPauseBanner("Serial Paused");
-    else
+    } else {
       oledPauseBanner("Serial Resumed");
+      dvDoSerial();  // pick up whatever queued while paused
+    }
     break;
   case MODE_VOLTS:
     // no modal behavior
     break;
   case MODE_OSCOPE:
-    speed_mode = speed_mode ? 0 : 1; // toggle speed mode
-    if( speed_mode ) 
-      oledPauseBanner("High speed");
+    scopeNextTimebase();
+    if( scopeIsEquivalentTime() )
+      chsnprintf(banner, sizeof(banner), "%dns equiv", scopeGetSampleNs());
     else
-      oledPauseBanner("Low speed");
+      chsnprintf(banner, sizeof(banner), "%dus/sample", scopeGetSampleNs() / 1000);
+    oledPauseBanner(banner);
     break;
   default:
     break;
@@ -211,7 +215,21 @@ static void option_handler(eventid_t id) {
 
 static void serial_handler(eventid_t id) {
   (void) id;
-  dvDoSerial();
+  if( serial_init )
+    dvDoSerial();
+}
+
+static void stream_handler(eventid_t id) {
+  (void) id;
+  streamFlush();
+}
+
+// the Redraw worker checks the mode under the gfx mutex before drawing, so switch it there too
+static void set_mode(uint8_t mode) {
+
+  orchardGfxStart();
+  current_mode = mode;
+  orchardGfxEnd();
 }
 
 static void mode_handler(eventid_t id) {
@@ -220,22 +238,23 @@ static void mode_handler(eventid_t id) {
   case MODE_SERIAL:
     oledPauseBanner("Volts Mode");
     serial_init = 0;
-    nvicDisableVector(UART0_IRQn);
-    current_mode = MODE_VOLTS;
+    if( !streamActive() )  // captures go out over the UART in wave mode
+      nvicDisableVector(UART0_IRQn);
+    set_mode(MODE_VOLTS);
     break;
   case MODE_VOLTS:
     oledPauseBanner("Wave Mode");
     serial_init = 1;
-    current_mode = MODE_OSCOPE;
-    palSetPadMode(IOPORT2, 2, PAL_MODE_INPUT_ANALOG);    
-    nvicEnableVector(CMP0_IRQn, KINETIS_CMP0_PRIORITY);
+    set_mode(MODE_OSCOPE);
+    oscopeStart();
     break;
   case MODE_OSCOPE:
-    nvicDisableVector(CMP0_IRQn);
-    palSetPadMode(IOPORT2, 2, PAL_MODE_ALTERNATIVE_2);    
+    oscopeStop();
     nvicEnableVector(UART0_IRQn, KINETIS_SERIAL_UART0_PRIORITY);
     oledPauseBanner("Waiting for text...");
-    current_mode = MODE_SERIAL;
+    set_mode(MODE_SERIAL);
+    // the UART only signals at the end of a burst, so drain anything left over
+    dvDoSerial();
     break;
   default:
     osalDbgAssert(false, "invalid operating mode");
@@ -250,7 +269,6 @@ static THD_FUNCTION(evHandlerThread, arg) {
   chRegSetThreadName("Event dispatcher");
 
   adcStart(&ADCD1, &adccfg1);
-  analogStart();
   oscopeInit();
 
   spiStart(&SPID1, &spi_config);
@@ -262,7 +280,17 @@ static THD_FUNCTION(evHandlerThread, arg) {
   chprintf(stream, "Copyright (c) 2016 Chibitronics PTE LTD\r\n", gitversion);
   chprintf(stream, "boot freemem: %d\r\n", chCoreGetStatusX());
 
-  evtTableInit(orchard_app_events, 6);
+  // hook order is dispatch priority, the first hooked is served first
+  orchardEventsStart();
+  evtTableInit(orchard_app_events, 7);
+
+  // wake once per received burst, not once per byte
+  current_mode = MODE_SERIAL;
+  evtTableHookFlags(orchard_app_events, serialDriver->event, serial_handler,
+		    SD_RX_IDLE | SD_RX_WATERMARK);
+
+  chEvtObjectInit(&stream_event);
+  evtTableHook(orchard_app_events, stream_event, stream_handler);
 
   chEvtObjectInit(&mode_event);
   evtTableHook(orchard_app_events, mode_event, mode_handler);
@@ -270,18 +298,23 @@ static THD_FUNCTION(evHandlerThread, arg) {
   chEvtObjectInit(&option_event);
   evtTableHook(orchard_app_events, option_event, option_handler);
 
-  chEvtObjectInit(&refresh_event);
-  evtTableHook(orchard_app_events, refresh_event, refresh_handler);
-
-  chEvtObjectInit(&serial_event);
-  current_mode = MODE_SERIAL;
-  evtTableHook(orchard_app_events, serial_event, serial_handler);
-
   chEvtObjectInit(&led_event);
   evtTableHook(orchard_app_events, led_event, led_handler);
 
+  chEvtObjectInit(&refresh_event);
+  evtTableHook(orchard_app_events, refresh_event, refresh_handler);
+
   // event object initialization happens in oscopeIinit
   evtTableHook(orchard_app_events, cmp_event, cmp_handler);
+
+  // full screen redraws take 10ms and more, keep them from holding up serial and the buttons
+  evtWorkerStart(orchard_app_events, redraw_worker, "Redraw", 0x300, NORMALPRIO + 5);
+  evtTableRunOn(orchard_app_events, refresh_handler, redraw_worker);
+  evtTableRunOn(orchard_app_events, cmp_handler, redraw_worker);
+
+  // a capture frame takes up to 20ms to trickle through the 8 byte TX queue
+  evtWorkerStart(orchard_app_events, stream_worker, "Stream", 0x180, NORMALPRIO + 6);
+  evtTableRunOn(orchard_app_events, stream_handler, stream_worker);
   
   extStart(&EXTD1, &ext_config); // enables interrupts on gpios
 
@@ -312,7 +345,7 @@ static THD_FUNCTION(evHandlerThread, arg) {
 
   dvInit();
   while(true) {
-    chEvtDispatch(evtHandlers(orchard_app_events), chEvtWaitOne(ALL_EVENTS));
+    evtTableDispatch(&orchard_app_events, chEvtWaitOne(ALL_EVENTS));
     //    if( current_mode == MODE_SERIAL )
     //      dvDoSerial(); // this grabs characters and processes them
   }
@@ -338,8 +371,9 @@ int main(void)
 
   evHandler_tp = chThdCreateStatic(waEvHandlerThread, sizeof(waEvHandlerThread), NORMALPRIO + 10, evHandlerThread, NULL);
 
+  // the idle thread does the sleeping now
   while (TRUE) {
-    // this is now an idle loop
+    chThdSleep(TIME_INFINITE);
   }
 
 }
@@ -56,6 +56,7 @@
  */
 #define KINETIS_SERIAL_USE_UART0              TRUE
 #define KINETIS_SERIAL_UART0_PRIORITY         2
+#define KINETIS_SERIAL_USE_RX_EVENTS          TRUE
 /*
  * EXTI driver system settings.
  */
@@ -87,15 +88,19 @@
  */
 #define KINETIS_ADC_USE_ADC0                  TRUE
 #define KINETIS_ADC_IRQ_PRIORITY              5
+#define KINETIS_ADC_USE_CONTINUOUS            TRUE
 #define KINETIS_CMP0_PRIORITY                 4
 
 /*
  * LPTMR driver system settings.
  */
 #define KINETIS_LPTMR0_PRIORITY                 1
+#define KINETIS_ST_IRQ_PRIORITY                 KINETIS_LPTMR0_PRIORITY  // tickless system timer
 
 #define KINETIS_PWM_USE_TPM0                    TRUE
 #define KINETIS_PWM_TPM0_IRQ_PRIORITY           7
+#define KINETIS_PWM_USE_TPM1                    TRUE    /* wave mode sample clock */
+#define KINETIS_PWM_TPM1_IRQ_PRIORITY           7
 
 /*
  * Processor specific widths of each port.
@@ -0,0 +1,109 @@
+#include "ch.h"
+#include "hal.h"
+
+#include "measure.h"
+
+/*
+  Measurements on one captured frame, all in integer math. Edges are found
+  with hysteresis around the midpoint of the frame's swing, then placed
+  between the two samples that straddle the midpoint by linear
+  interpolation, in 1/256ths of a sample. That's what makes the frequency
+  readout usable when a period is only a handful of samples long.
+ */
+
+#define EDGE_FRAC_BITS  8
+
+// where, between samples i - 1 and i, the signal crossed mid
+static uint32_t edge_position(const adcsample_t *samples, size_t i, uint16_t mid) {
+  int32_t a = samples[i - 1];
+  int32_t b = samples[i];
+  int32_t frac;
+
+  frac = ((mid - a) << EDGE_FRAC_BITS) / (b - a);
+  return ((i - 1) << EDGE_FRAC_BITS) + frac;
+}
+
+void measureFrame(const adcsample_t *samples, size_t n, uint32_t sample_counts,
+                  uint32_t timer_hz, struct scope_measure *m) {
+  uint32_t sum = 0;
+  uint16_t min = 0xFFFF, max = 0;
+  uint16_t mid, hyst;
+  uint32_t cand_rise = 0, cand_fall = 0;
+  uint32_t first_rise = 0, last_rise = 0;
+  uint32_t high_sum = 0;
+  uint16_t rises = 0, highs = 0;
+  uint32_t period;
+  uint8_t high;
+  size_t i;
+
+  m->period_us = 0;
+  m->freq_hz = 0;
+  m->duty = 0;
+
+  if( n == 0 ) {
+    m->min = m->max = m->mean = m->vpp_mv = 0;
+    return;
+  }
+
+  for( i = 0; i < n; i++ ) {
+    if( samples[i] < min )
+      min = samples[i];
+    if( samples[i] > max )
+      max = samples[i];
+    sum += samples[i];
+  }
+
+  m->min = min;
+  m->max = max;
+  m->mean = sum / n;
+  m->vpp_mv = ((uint32_t) (max - min) * MEASURE_VREF_MV) / MEASURE_FULL_SCALE;
+
+  if( (max - min) < MEASURE_MIN_SWING )
+    return;
+
+  mid = min + (max - min) / 2;
+  hyst = (max - min) / 8;
+  high = samples[0] >= mid;
+
+  for( i = 1; i < n; i++ ) {
+    // remember the latest midpoint crossing, commit it once past the hysteresis band
+    if( (samples[i - 1] < mid) && (samples[i] >= mid) )
+      cand_rise = edge_position(samples, i, mid);
+    else if( (samples[i - 1] >= mid) && (samples[i] < mid) )
+      cand_fall = edge_position(samples, i, mid);
+
+    if( !high && (samples[i] >= mid + hyst) ) {
+      high = 1;
+      if( rises == 0 )
+        first_rise = cand_rise;
+      last_rise = cand_rise;
+      rises++;
+    }
+    else if( high && (samples[i] < mid - hyst) ) {
+      high = 0;
+      if( rises ) {
+        high_sum += cand_fall - last_rise;
+        highs++;
+      }
+    }
+  }
+
+  if( rises < 2 )
+    return;
+
+  period = (last_rise - first_rise) / (rises - 1);
+  if( period == 0 )
+    return;
+
+  if( highs ) {
+    high_sum = ((high_sum / highs) * 100) / period;
+    m->duty = high_sum > 100 ? 100 : high_sum;
+  }
+
+  // scale by the programmed timer counts per sample rather than a rounded
+  // sample time, so the readouts stay exact at the fast timebases
+  m->period_us = (uint32_t) ((((uint64_t) period * sample_counts * 1000000) / timer_hz)
+                             >> EDGE_FRAC_BITS);
+  m->freq_hz = (uint32_t) (((uint64_t) timer_hz << EDGE_FRAC_BITS)
+                           / ((uint64_t) period * sample_counts));
+}
@@ -0,0 +1,21 @@
+#ifndef __MEASURE_H__
+#define __MEASURE_H__
+
+#define MEASURE_VREF_MV     3300   // ADC reference is VDD
+#define MEASURE_FULL_SCALE  4096   // 12 bit samples
+#define MEASURE_MIN_SWING   64     // counts; anything smaller is noise, not a waveform
+
+struct scope_measure {
+  uint16_t min;        // raw counts
+  uint16_t max;
+  uint16_t mean;
+  uint16_t vpp_mv;
+  uint32_t period_us;  // 0 if fewer than two like edges landed in the frame
+  uint32_t freq_hz;
+  uint8_t  duty;       // percent high, 0 if unknown
+};
+
+void measureFrame(const adcsample_t *samples, size_t n, uint32_t sample_counts,
+                  uint32_t timer_hz, struct scope_measure *m);
+
+#endif /* __MEASURE_H__ */
@@ -9,6 +9,28 @@
 
 static SPIDriver *driver;
 
+/*
+  Dirty-region tracking for flushes.
+
+  uGFX always pushes the whole framebuffer, one 128-byte page per oledData()
+  call. Instead of keeping a 1k shadow copy of what the panel holds (we don't
+  have the RAM) we keep a signature for every 16-column block of every page,
+  and only send the span of blocks whose signature changed, addressed with
+  an explicit column/page window.
+ */
+#define OLED_WIDTH        128
+#define OLED_PAGES        8
+#define OLED_FRAME_BYTES  (OLED_WIDTH * OLED_PAGES)
+#define OLED_BLOCK        16  // columns covered by one signature
+#define OLED_BLOCKS       (OLED_WIDTH / OLED_BLOCK)
+
+#define SSD1306_COLUMNADDR  0x21
+#define SSD1306_PAGEADDR    0x22
+
+static uint32_t block_sig[OLED_PAGES][OLED_BLOCKS];
+static uint8_t page_valid = 0;       // bit per page: block_sig matches what the panel shows
+static uint16_t frame_offset = 0;    // where in the frame the next data byte lands
+
 // mutex to lock the graphics subsystem for safe multi-threaded drawing
 mutex_t orchard_gfxMutex;
 
@@ -63,6 +85,8 @@ void oledStop(SPIDriver *spip) {
 void oledStart(SPIDriver *spip) {
 
   driver = spip;
+  page_valid = 0;
+  frame_offset = 0;
 
   palWritePad(GPIOB, 11, PAL_HIGH);  // oled_res
 }
@@ -74,12 +98,67 @@ void oledCmd(uint8_t cmd) {
   spiSend(driver, 1, &cmd);
 }
 
-void oledData(uint8_t *data, uint16_t length) {
-  unsigned int i;
+static void oled_send(uint8_t *data, uint16_t length) {
 
   oled_data_mode();
-  for( i = 0; i < length; i++ )
-    spiSend(driver, 1, &data[i]);
+  spiSend(driver, length, data);
+}
+
+// FNV-1a; collisions would leave a stale block on screen, so not just a sum
+static uint32_t oled_block_sig(const uint8_t *data) {
+  uint32_t h = 2166136261UL;
+  int i;
+
+  for( i = 0; i < OLED_BLOCK; i++ ) {
+    h ^= data[i];
+    h *= 16777619UL;
+  }
+
+  return h;
+}
+
+void oledData(uint8_t *data, uint16_t length) {
+  uint8_t page, b, first, last;
+  uint32_t sig;
+
+  // not whole pages: send it as-is and stop trusting the signatures
+  if( (length % OLED_WIDTH) || (frame_offset % OLED_WIDTH) ) {
+    oled_send(data, length);
+    page_valid = 0;
+    frame_offset = (frame_offset + length) % OLED_FRAME_BYTES;
+    return;
+  }
+
+  while( length ) {
+    page = frame_offset / OLED_WIDTH;
+
+    first = OLED_BLOCKS;
+    last = 0;
+    for( b = 0; b < OLED_BLOCKS; b++ ) {
+      sig = oled_block_sig(&data[b * OLED_BLOCK]);
+      if( !(page_valid & (1 << page)) || (sig != block_sig[page][b]) ) {
+        block_sig[page][b] = sig;
+        if( first == OLED_BLOCKS )
+          first = b;
+        last = b;
+      }
+    }
+
+    if( first < OLED_BLOCKS ) {
+      oledCmd(SSD1306_COLUMNADDR);
+      oledCmd(first * OLED_BLOCK);
+      oledCmd(((last + 1) * OLED_BLOCK) - 1);
+      oledCmd(SSD1306_PAGEADDR);
+      oledCmd(page);
+      oledCmd(page);
+      oled_send(&data[first * OLED_BLOCK], (last - first + 1) * OLED_BLOCK);
+    }
+
+    page_valid |= (1 << page);
+    data += OLED_WIDTH;
+    length -= OLED_WIDTH;
+    frame_offset = (frame_offset + OLED_WIDTH) % OLED_FRAME_BYTES;
+  }
 }
 
 void oledAcquireBus(void) {
@@ -1,15 +1,118 @@
 #include "ch.h"
 #include "hal.h"
-#include "ext.h"
+#include "chprintf.h"
 #include "orchard-events.h"
 
+/*
+  Handler run times come off SysTick, left free-running at the core clock
+  since the system tick is on the LPTMR. Its 24 bits wrap every 350ms at
+  48MHz, so the system time elapsed over the run picks the right number
+  of wraps for the slow handlers.
+ */
+#if OSAL_ST_MODE != OSAL_ST_MODE_FREERUNNING
+#error "handler timing needs SysTick, which the periodic system tick uses"
+#endif
 
-static const EXTConfig ext_config = {
-  {
-    
-  }
-};
+#define EVT_CLOCK_BITS      24
+#define EVT_CLOCK_MASK      ((1UL << EVT_CLOCK_BITS) - 1)
 
 void orchardEventsStart(void) {
 
+  SysTick->LOAD = EVT_CLOCK_MASK;
+  SysTick->VAL = 0;
+  SysTick->CTRL = SysTick_CTRL_CLKSOURCE_Msk | SysTick_CTRL_ENABLE_Msk;
+}
+
+static uint32_t evt_cycles(uint32_t start, uint32_t end, systime_t ticks) {
+  uint64_t coarse;
+  uint32_t fine, wraps;
+
+  fine = (start - end) & EVT_CLOCK_MASK;  // SysTick counts down
+  coarse = ((uint64_t) ticks * KINETIS_SYSCLK_FREQUENCY) / CH_CFG_ST_FREQUENCY;
+  if( coarse <= fine )
+    return fine;
+
+  // nearest whole number of wraps, the tick is only good to a tick either way
+  wraps = (uint32_t) ((coarse - fine + (1UL << (EVT_CLOCK_BITS - 1))) >> EVT_CLOCK_BITS);
+  if( wraps >= (1UL << (32 - EVT_CLOCK_BITS)) )
+    return UINT32_MAX;
+  return fine + (wraps << EVT_CLOCK_BITS);
+}
+
+static void evt_run(struct evt_table *table, eventid_t id) {
+  struct evt_stats *stats = &table->stats[id];
+  systime_t start;
+  uint32_t start_cnt, elapsed;
+
+  start = chVTGetSystemTimeX();
+  start_cnt = SysTick->VAL;
+  table->handlers[id](id);
+  elapsed = evt_cycles(start_cnt, SysTick->VAL, chVTTimeElapsedSinceX(start));
+
+  stats->runs++;
+  stats->total += elapsed;
+  if( elapsed > stats->max )
+    stats->max = elapsed;
+}
+
+// run each pending event, or hand it on to the worker that owns it
+void evtTableDispatch(struct evt_table *table, eventmask_t events) {
+  struct evt_worker *worker;
+  eventid_t id = 0;
+
+  while( events && (id < (eventid_t) table->next) ) {
+    if( events & EVENT_MASK(id) ) {
+      events &= ~EVENT_MASK(id);
+      worker = table->workers[id];
+      if( worker == NULL ) {
+        evt_run(table, id);
+      }
+      else {
+        chSysLock();
+        if( worker->thread->p_epending & EVENT_MASK(id) )
+          table->stats[id].coalesced++;
+        chEvtSignalI(worker->thread, EVENT_MASK(id));
+        chSchRescheduleS();
+        chSysUnlock();
+      }
+    }
+    id++;
+  }
+}
+
+// one line per handler: runs, average and longest run in core cycles, merged events
+void evtTablePrintStats(BaseSequentialStream *chp, struct evt_table *table) {
+  struct evt_stats *stats;
+  uint32_t avg;
+  int i;
+
+  chprintf(chp, " id runs       avg(cyc)   max(cyc)   merged thread       handler\r\n");
+  for( i = 0; i < table->next; i++ ) {
+    stats = &table->stats[i];
+    avg = 0;
+    if( stats->runs )
+      avg = (uint32_t) (stats->total / stats->runs);
+    chprintf(chp, " %2d %-10lu %-10lu %-10lu %-6u %-12s %s\r\n",
+      i, stats->runs, avg, stats->max, stats->coalesced,
+      table->workers[i] ? table->workers[i]->name : "Dispatcher",
+      table->names[i]);
+  }
+}
+
+THD_FUNCTION(evtWorkerThread, arg) {
+  struct evt_worker *worker = arg;
+  eventmask_t events;
+  eventid_t id;
+
+  chRegSetThreadName(worker->name);
+
+  while( true ) {
+    events = chEvtWaitAny(ALL_EVENTS);
+    for( id = 0; events; id++ ) {
+      if( events & EVENT_MASK(id) ) {
+        events &= ~EVENT_MASK(id);
+        evt_run(worker->table, id);
+      }
+    }
+  }
 }
@@ -20,11 +20,24 @@
 
     // Dispatch all events
     while (TRUE)
-      chEvtDispatch(evtHandlers(events), chEvtWaitOne(ALL_EVENTS));
+      evtTableDispatch(&events, chEvtWaitOne(ALL_EVENTS));
    }
+
+  chEvtWaitOne() serves the lowest pending event first, so hook order is
+  priority order. A slow handler can be moved onto a worker thread of its
+  own priority, so it no longer holds up the rest of the table:
+
+    static struct evt_worker redraw;
+
+    evtWorkerStart(events, redraw, "Redraw", 0x300, NORMALPRIO);
+    evtTableRunOn(events, screen_handler, redraw);
+
+  Events forwarded to a worker that hasn't run yet are merged into the
+  pending run rather than queued. Each handler's run count, run time and
+  merged events are kept in the table's stats. Run times are in core
+  clock cycles off SysTick, which orchardEventsStart() sets free-running.
  */
 
-extern event_source_t serial_event;
 extern event_source_t refresh_event;
 
 struct ui_info {
@@ -38,21 +51,45 @@ typedef enum _font_codes {
   font_large,
 } font_codes;
 
+struct evt_stats {
+  uint32_t runs;
+  uint64_t total;       // core clock cycles spent in the handler
+  uint32_t max;         // longest run, in cycles
+  uint16_t coalesced;   // events merged into a run that was already pending
+};
+
+struct evt_worker;
+
 struct evt_table {
   int size;
   int next;
   evhandler_t *handlers;
   event_listener_t *listeners;
+  const char **names;
+  struct evt_stats *stats;
+  struct evt_worker **workers;  // NULL runs the handler on the dispatching thread
+};
+
+struct evt_worker {
+  const char *name;
+  thread_t *thread;
+  struct evt_table *table;
 };
 
 #define evtTableInit(table, capacity)                                       \
   do {                                                                      \
     static evhandler_t handlers[capacity];                                  \
     static event_listener_t listeners[capacity];                            \
+    static const char *names[capacity];                                     \
+    static struct evt_stats stats[capacity];                                \
+    static struct evt_worker *workers[capacity];                            \
     table.size = capacity;                                                  \
     table.next = 0;                                                         \
     table.handlers = handlers;                                              \
     table.listeners = listeners;                                            \
+    table.names = names;                                                    \
+    table.stats = stats;                                                    \
+    table.workers = workers;                                                \
   } while(0)
 
 #define evtTableHook(table, event, callback)                                \
@@ -62,6 +99,20 @@ struct evt_table {
         chSysHalt("event table overflow");                                  \
     chEvtRegister(&event, &table.listeners[table.next], table.next);        \
     table.handlers[table.next] = callback;                                  \
+    table.names[table.next] = #callback;                                    \
+    table.next++;                                                           \
+  } while(0)
+
+/* Like evtTableHook(), but only wake up for the given event flags */
+#define evtTableHookFlags(table, event, callback, flags)                    \
+  do {                                                                      \
+    if (CH_DBG_ENABLE_ASSERTS != FALSE)                                     \
+      if (table.next >= table.size)                                         \
+        chSysHalt("event table overflow");                                  \
+    chEvtRegisterMaskWithFlags(&event, &table.listeners[table.next],        \
+                               EVENT_MASK(table.next), flags);              \
+    table.handlers[table.next] = callback;                                  \
+    table.names[table.next] = #callback;                                    \
     table.next++;                                                           \
   } while(0)
 
@@ -74,6 +125,26 @@ struct evt_table {
     }                                                                       \
   } while(0)
 
+/* Start a worker thread for handlers moved off the dispatching thread */
+#define evtWorkerStart(tbl, wrk, thread_name, stack, prio)                  \
+  do {                                                                      \
+    static THD_WORKING_AREA(wa, stack);                                     \
+    wrk.name = thread_name;                                                 \
+    wrk.table = &tbl;                                                       \
+    wrk.thread = chThdCreateStatic(wa, sizeof(wa), prio,                    \
+                                   evtWorkerThread, &wrk);                  \
+  } while(0)
+
+/* Run an already hooked callback on the given worker from now on */
+#define evtTableRunOn(table, callback, worker)                              \
+  do {                                                                      \
+    int i;                                                                  \
+    for (i = 0; i < table.next; i++) {                                      \
+      if (table.handlers[i] == callback)                                    \
+        table.workers[i] = &worker;                                         \
+    }                                                                       \
+  } while(0)
+
 #define evtHandlers(table)                                                  \
     table.handlers
 
@@ -81,6 +152,9 @@ struct evt_table {
     table.listeners
 
 void orchardEventsStart(void);
+void evtTableDispatch(struct evt_table *table, eventmask_t events);
+void evtTablePrintStats(BaseSequentialStream *chp, struct evt_table *table);
+THD_FUNCTION(evtWorkerThread, arg);
 
 /// Orchard App events
 
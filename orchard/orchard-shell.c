@@ -27,6 +27,7 @@ orchard_command_end();
 
 static const SerialConfig serialConfig = {
   9600,
+  SERIAL_BUFFER_RX_SIZE / 2,  // wake up half way through a long burst
 };
 
 static thread_t *shell_tp = NULL;
@@ -42,6 +43,30 @@ void orchardShellInit(void)
   //  shellInit();
 }
 
+/* Restarts the serial link at another speed, 0 goes back to the default.*/
+void orchardSerialSpeed(uint32_t speed)
+{
+  static SerialConfig config;
+
+  /* Let whatever is still queued go out at the old speed, including the
+     byte in the shifter.*/
+  osalSysLock();
+  while (!oqIsEmptyI(&serialDriver->oqueue)) {
+    osalSysUnlock();
+    chThdSleepMilliseconds(1);
+    osalSysLock();
+  }
+  osalSysUnlock();
+  while (!(serialDriver->uart->S1 & UARTx_S1_TC))
+    ;
+
+  config = serialConfig;
+  if (speed)
+    config.sc_speed = speed;
+  sdStop(serialDriver);
+  sdStart(serialDriver, &config);
+}
+
 void orchardShellRestart(void)
 {
   static ShellConfig shellConfig;
@@ -9,6 +9,7 @@
 
 void orchardShellInit(void);
 void orchardShellRestart(void);
+void orchardSerialSpeed(uint32_t speed);
 
 #define orchard_command_start() \
 ({ \
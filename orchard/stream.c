@@ -0,0 +1,167 @@
+#include "ch.h"
+#include "hal.h"
+
+#include "orchard.h"
+#include "orchard-shell.h"
+#include "analog.h"
+#include "stream.h"
+
+/*
+  Binary capture streaming. Every completed half of the capture ring goes
+  out over the serial link as one frame:
+
+    sync seq count first_lo first_hi width  deltas...  checksum
+
+  seq counts every block captured while streaming, so the host can spot the
+  ones dropped because the link was still busy with the previous frame.
+  Each sample after the first is sent as the difference from the one before,
+  zigzag coded so small negative steps stay small, and packed LSB first at
+  width bits apiece, width being just enough for the largest step in this
+  block. A slow signal costs a few bits a sample rather than twelve.
+  checksum is the 8 bit sum of every byte after sync.
+ */
+
+event_source_t stream_event;
+
+// one half of the ring, copied out in the ADC interrupt and packed in place
+static adcsample_t stream_block[SCOPE_RING_DEPTH / 2];  // count is sent as one byte
+static uint8_t stream_count;
+static uint8_t stream_block_seq;
+static volatile uint8_t stream_full = 0;  // stream_block waits to be sent
+
+static uint8_t stream_on = 0;
+static uint8_t stream_seq;
+
+// held while a frame goes out, so the link speed never changes under one
+static MUTEX_DECL(stream_mutex);
+
+// zigzag delta and pack samples[1..n-1] into the front of the buffer, returns bytes used
+static size_t stream_pack(adcsample_t *samples, uint8_t n, uint8_t *width) {
+  uint8_t *out = (uint8_t *) samples;
+  uint16_t prev, zz, maxzz = 0;
+  int16_t d;
+  uint32_t acc = 0;
+  uint8_t bits = 0;
+  uint8_t w = 0;
+  size_t pos = 0;
+  int i;
+
+  prev = samples[0];
+  for( i = 1; i < n; i++ ) {
+    d = samples[i] - prev;
+    prev = samples[i];
+    zz = (d < 0) ? (uint16_t)((-d << 1) - 1) : (uint16_t)(d << 1);
+    samples[i] = zz;
+    if( zz > maxzz )
+      maxzz = zz;
+  }
+
+  while( (1U << w) <= maxzz )
+    w++;
+  *width = w;
+
+  // after i samples we've written at most 13*i bits, and sample i+1 starts at byte 2*(i+1)
+  for( i = 1; i < n; i++ ) {
+    acc |= (uint32_t) samples[i] << bits;
+    bits += w;
+    while( bits >= 8 ) {
+      out[pos++] = acc;
+      acc >>= 8;
+      bits -= 8;
+    }
+  }
+  if( bits )
+    out[pos++] = acc;
+
+  return pos;
+}
+
+// called from the ADC callback with each completed half of the ring
+void streamBlockI(const adcsample_t *samples, size_t n) {
+  size_t i;
+
+  if( !stream_on )
+    return;
+
+  stream_seq++;
+  if( stream_full )
+    return;  // the link is behind, the gap in seq tells the host
+
+  for( i = 0; i < n; i++ )
+    stream_block[i] = samples[i];
+  stream_count = n;
+  stream_block_seq = stream_seq;
+  stream_full = 1;
+
+  chEvtBroadcastI(&stream_event);
+}
+
+// pack and send the waiting block, if there is one; blocks until it is queued
+void streamFlush(void) {
+  uint8_t header[6];
+  uint8_t width;
+  uint8_t sum = 0;
+  size_t len, i;
+
+  chMtxLock(&stream_mutex);
+  if( !stream_full ) {
+    chMtxUnlock(&stream_mutex);
+    return;
+  }
+
+  header[0] = STREAM_SYNC;
+  header[1] = stream_block_seq;
+  header[2] = stream_count;
+  header[3] = stream_block[0] & 0xff;
+  header[4] = stream_block[0] >> 8;
+  len = stream_pack(stream_block, stream_count, &width);
+  header[5] = width;
+
+  for( i = 1; i < sizeof(header); i++ )
+    sum += header[i];
+  for( i = 0; i < len; i++ )
+    sum += ((uint8_t *) stream_block)[i];
+
+  chSequentialStreamWrite((BaseSequentialStream *) stream, header, sizeof(header));
+  chSequentialStreamWrite((BaseSequentialStream *) stream, (uint8_t *) stream_block, len);
+  chSequentialStreamWrite((BaseSequentialStream *) stream, &sum, 1);
+
+  stream_full = 0;
+  chMtxUnlock(&stream_mutex);
+}
+
+void streamStart(void) {
+
+  if( stream_on )
+    return;
+
+  chMtxLock(&stream_mutex);
+  orchardSerialSpeed(STREAM_BAUD);
+
+  osalSysLock();
+  stream_seq = 0;
+  stream_full = 0;
+  stream_on = 1;
+  osalSysUnlock();
+  chMtxUnlock(&stream_mutex);
+}
+
+void streamStop(void) {
+
+  if( !stream_on )
+    return;
+
+  osalSysLock();
+  stream_on = 0;
+  osalSysUnlock();
+
+  // the frame in flight, if any, finishes at the streaming speed
+  chMtxLock(&stream_mutex);
+  stream_full = 0;
+  orchardSerialSpeed(0);
+  chMtxUnlock(&stream_mutex);
+}
+
+uint8_t streamActive(void) {
+  return stream_on;
+}
@@ -0,0 +1,15 @@
+#ifndef __STREAM_H__
+#define __STREAM_H__
+
+#define STREAM_SYNC   0xA5     // first byte of every frame
+#define STREAM_BAUD   115200   // link speed while streaming, 9600 leaves no room
+
+extern event_source_t stream_event;
+
+void streamStart(void);
+void streamStop(void);
+uint8_t streamActive(void);
+void streamBlockI(const adcsample_t *samples, size_t n);
+void streamFlush(void);
+
+#endif /* __STREAM_H__ */
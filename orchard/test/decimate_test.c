@@ -0,0 +1,234 @@
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "decimate.h"
+
+/*
+  Host test for decimateMinMax(). Rows are checked against a plain divide
+  reference, columns against the samples they cover, for both more samples
+  than columns (min/max envelope) and fewer (repeated samples).
+ */
+
+#define HEIGHT 64
+
+static int failures = 0;
+
+#define CHECK(cond, ...)                        \
+  do {                                          \
+    if( !(cond) ) {                             \
+      printf("FAIL %s:%d: ", __func__, __LINE__); \
+      printf(__VA_ARGS__);                      \
+      printf("\n");                             \
+      failures++;                               \
+    }                                           \
+  } while(0)
+
+// exact version of the scaling decimateMinMax() does with a reciprocal
+struct scale {
+  uint16_t min, max, offset, height;
+};
+
+static struct scale ref_scale(const uint16_t *samples, uint16_t n, uint16_t height) {
+  struct scale sc = { 0xFFFF, 0, 0, height };
+  uint32_t span;
+  uint16_t i;
+
+  for( i = 0; i < n; i++ ) {
+    if( samples[i] > sc.max )
+      sc.max = samples[i];
+    if( samples[i] < sc.min )
+      sc.min = samples[i];
+  }
+  if( sc.max == 0 )
+    sc.max = 1;
+
+  span = (uint32_t) (sc.max - sc.min) * height / sc.max;
+  sc.offset = (span < height) ? (height - span) / 2 : 0;
+  return sc;
+}
+
+static int ref_row(const struct scale *sc, uint16_t s) {
+  uint32_t y = (uint32_t) (s - sc->min) * sc->height / sc->max + sc->offset;
+
+  return (y > (uint32_t) (sc->height - 1)) ? sc->height - 1 : (int) y;
+}
+
+// the reciprocal truncates the scale, and with it the centering offset, by under a row each
+static void check_rows(const char *name, const struct scale *sc, int row, uint16_t s) {
+  int want = ref_row(sc, s);
+
+  CHECK(abs(row - want) <= 1, "%s: sample %u at row %d, expected %d", name, s, row, want);
+}
+
+// every column spans the rows of its own samples, stretched to meet the column before
+static void check_envelope(const char *name, const uint16_t *samples, uint16_t n,
+                           const wave_span_t *cols, uint16_t ncols, uint16_t height) {
+  struct scale sc = ref_scale(samples, n, height);
+  uint16_t per = n / ncols;
+  uint16_t c, i, lo, hi;
+
+  for( c = 0; c < ncols; c++ ) {
+    lo = hi = samples[c * per];
+    for( i = c * per + 1; i < (c + 1) * per; i++ ) {
+      if( samples[i] < lo )
+        lo = samples[i];
+      if( samples[i] > hi )
+        hi = samples[i];
+    }
+
+    CHECK(cols[c].lo <= cols[c].hi, "%s: column %u upside down", name, c);
+    // an end only moves off its own sample to reach the column before
+    if( (c == 0) || (cols[c].hi != cols[c - 1].lo) )
+      check_rows(name, &sc, cols[c].hi, hi);
+    else
+      CHECK(cols[c].hi >= ref_row(&sc, hi) - 1, "%s: column %u hi %u below its max",
+            name, c, cols[c].hi);
+    if( (c == 0) || (cols[c].lo != cols[c - 1].hi) )
+      check_rows(name, &sc, cols[c].lo, lo);
+    else
+      CHECK(cols[c].lo <= ref_row(&sc, lo) + 1, "%s: column %u lo %u above its min",
+            name, c, cols[c].lo);
+    if( c > 0 )
+      CHECK((cols[c].lo <= cols[c - 1].hi) && (cols[c].hi >= cols[c - 1].lo),
+            "%s: column %u does not meet column %u", name, c, c - 1);
+  }
+}
+
+// sine-ish test signal with some spikes, on a DC level
+static void make_signal(uint16_t *samples, uint16_t n, uint16_t dc) {
+  static const int16_t wave[16] = {
+    0, 150, 280, 370, 400, 370, 280, 150, 0, -150, -280, -370, -400, -370, -280, -150,
+  };
+  uint16_t i;
+
+  for( i = 0; i < n; i++ )
+    samples[i] = dc + wave[i % 16];
+  samples[n / 3] = dc + 900;  // a one sample spike must survive decimation
+  samples[n / 2] = dc - 700;
+}
+
+static void test_scaling(void) {
+  uint16_t samples[64];
+  wave_span_t cols[64];
+  struct scale sc;
+  uint16_t i;
+
+  // a ramp at one sample per column, so each column holds exactly its sample's row
+  for( i = 0; i < 64; i++ )
+    samples[i] = 1000 + i * 47;
+  decimateMinMax(samples, 64, cols, 64, HEIGHT);
+  sc = ref_scale(samples, 64, HEIGHT);
+  for( i = 0; i < 64; i++ )
+    check_rows("ramp", &sc, cols[i].hi, samples[i]);
+
+  // full scale from zero lands on the top row, not past it
+  for( i = 0; i < 64; i++ )
+    samples[i] = (i & 1) ? 4095 : 0;
+  decimateMinMax(samples, 64, cols, 64, HEIGHT);
+  CHECK(cols[1].hi == HEIGHT - 1, "full scale at row %u", cols[1].hi);
+  CHECK(cols[0].lo == 0, "zero at row %u", cols[0].lo);
+
+  // a flat trace sits on one row, all zero must not divide by zero
+  for( i = 0; i < 64; i++ )
+    samples[i] = 2000;
+  decimateMinMax(samples, 64, cols, 64, HEIGHT);
+  for( i = 0; i < 64; i++ )
+    CHECK(cols[i].lo == cols[0].lo && cols[i].hi == cols[0].lo, "flat column %u", i);
+
+  memset(samples, 0, sizeof(samples));
+  decimateMinMax(samples, 64, cols, 64, HEIGHT);
+  CHECK(cols[0].lo == cols[0].hi, "zero trace column 0");
+}
+
+static void test_more_samples(void) {
+  uint16_t samples[256], copy[256];
+  wave_span_t cols[128];
+  struct scale sc;
+  uint16_t i, c;
+  int spike_hi = 0, spike_lo = 0;
+
+  // 4 samples per column
+  make_signal(samples, 256, 2000);
+  decimateMinMax(samples, 256, cols, 64, HEIGHT);
+  check_envelope("256/64", samples, 256, cols, 64, HEIGHT);
+
+  // the spikes show up in the columns that hold them
+  sc = ref_scale(samples, 256, HEIGHT);
+  for( c = 0; c < 64; c++ ) {
+    if( cols[c].hi >= ref_row(&sc, 2000 + 900) - 1 )
+      spike_hi = 1;
+    if( cols[c].lo <= ref_row(&sc, 2000 - 700) + 1 )
+      spike_lo = 1;
+  }
+  CHECK(spike_hi && spike_lo, "spikes lost, hi %d lo %d", spike_hi, spike_lo);
+
+  // 2 samples per column, decimated in place the way draw_wave() does it
+  make_signal(samples, 256, 1500);
+  memcpy(copy, samples, sizeof(copy));
+  decimateMinMax(copy, 256, cols, 128, HEIGHT);
+  decimateMinMax(samples, 256, (wave_span_t *) samples, 128, HEIGHT);
+  CHECK(!memcmp(samples, cols, 128 * sizeof(wave_span_t)), "in place result differs");
+
+  // a step that does not divide evenly still covers every sample
+  make_signal(samples, 200, 2500);
+  decimateMinMax(samples, 200, cols, 96, HEIGHT);
+  sc = ref_scale(samples, 200, HEIGHT);
+  for( i = 0; i < 200; i++ ) {
+    int row = ref_row(&sc, samples[i]);
+
+    for( c = 0; c < 96; c++ ) {
+      if( (cols[c].lo <= row + 1) && (cols[c].hi + 1 >= row) )
+        break;
+    }
+    CHECK(c < 96, "200/96: sample %u at row %d in no column", i, row);
+  }
+}
+
+static void test_fewer_samples(void) {
+  uint16_t samples[32];
+  wave_span_t cols[128];
+  struct scale sc;
+  uint16_t c;
+
+  // a rising ramp: each sample is repeated over 4 columns
+  for( c = 0; c < 32; c++ )
+    samples[c] = 500 + c * 100;
+  decimateMinMax(samples, 32, cols, 128, HEIGHT);
+  sc = ref_scale(samples, 32, HEIGHT);
+
+  for( c = 0; c < 128; c++ ) {
+    check_rows("32/128", &sc, cols[c].hi, samples[c / 4]);
+    if( (c % 4) != 0 )
+      CHECK(cols[c].lo == cols[c].hi, "32/128: repeated column %u spans %u..%u",
+            c, cols[c].lo, cols[c].hi);
+    else if( c > 0 )
+      CHECK(cols[c].lo == cols[c - 1].hi, "32/128: column %u not joined to %u", c, c - 1);
+  }
+
+  // fewer samples than columns, not an even multiple
+  for( c = 0; c < 30; c++ )
+    samples[c] = (c & 1) ? 3000 : 1000;
+  decimateMinMax(samples, 30, cols, 128, HEIGHT);
+  sc = ref_scale(samples, 30, HEIGHT);
+  for( c = 0; c < 128; c++ ) {
+    CHECK(cols[c].lo <= cols[c].hi, "30/128: column %u upside down", c);
+    CHECK(cols[c].hi <= HEIGHT - 1, "30/128: column %u off screen", c);
+  }
+  CHECK(cols[127].hi >= ref_row(&sc, samples[29]) - 1, "30/128: last sample not reached");
+}
+
+int main(void) {
+
+  test_scaling();
+  test_more_samples();
+  test_fewer_samples();
+
+  if( failures ) {
+    printf("decimate: %d failures\n", failures);
+    return 1;
+  }
+  printf("decimate: ok\n");
+  return 0;
+}
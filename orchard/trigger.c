@@ -0,0 +1,235 @@
+#include "ch.h"
+#include "hal.h"
+#include "chprintf.h"
+
+#include "orchard.h"
+#include "analog.h"
+#include "trigger.h"
+
+/*
+  Trigger engine. CMP0 compares the scope input against its 6 bit DAC and
+  interrupts on the selected edge(s). A trigger marks the edge in the
+  capture ring and disarms the comparator; once the capture engine has the
+  window around it, it calls triggerRearmI() straight from the ADC interrupt,
+  so the time spent drawing a frame is no longer dead time for triggering.
+ */
+
+static const char *edge_names[] = { "rising", "falling", "both" };
+static const char *mode_names[] = { "auto", "normal", "single" };
+
+static trigger_edge trig_edge = trigEdgeFalling;
+static trigger_mode trig_mode = trigModeAuto;
+static uint8_t trig_threshold = TRIGGER_THRESHOLD_DEFAULT;
+static uint16_t trig_holdoff_ms = 0;
+
+static uint8_t trig_running = 0;
+static virtual_timer_t holdoff_vt;
+static systime_t last_capture_time = 0;
+
+static uint8_t edge_bits(void) {
+  switch( trig_edge ) {
+  case trigEdgeRising:
+    return CMP_SCR_IER_MASK;
+  case trigEdgeBoth:
+    return CMP_SCR_IER_MASK | CMP_SCR_IEF_MASK;
+  case trigEdgeFalling:
+  default:
+    return CMP_SCR_IEF_MASK;
+  }
+}
+
+static void cmp_enable(void) {
+  CMP0->SCR = edge_bits() | CMP_SCR_CFR_MASK | CMP_SCR_CFF_MASK; // clear interrupt status
+  nvicEnableVector(CMP0_IRQn, KINETIS_CMP0_PRIORITY);
+}
+
+static void cmp_disable(void) {
+  nvicDisableVector(CMP0_IRQn);
+  CMP0->SCR = CMP_SCR_CFR_MASK | CMP_SCR_CFF_MASK;
+}
+
+static void holdoff_cb(void *arg) {
+  (void) arg;
+
+  osalSysLockFromISR();
+  if( trig_running )
+    cmp_enable();
+  osalSysUnlockFromISR();
+}
+
+// an edge (or auto mode's timeout) wants a capture; stays disarmed until the window is in
+static void trigger_fire_I(void) {
+
+  if( scopeTriggerI() ) {
+    cmp_disable();
+    last_capture_time = chVTGetSystemTimeX();
+  }
+}
+
+// called by the capture engine, from its interrupt, once the window is copied out
+void triggerRearmI(void) {
+
+  if( !trig_running )
+    return;
+
+  if( trig_mode == trigModeSingle ) {
+    trig_running = 0;  // hold this capture on screen until triggerArm()
+    return;
+  }
+
+  if( trig_holdoff_ms )
+    chVTSetI(&holdoff_vt, MS2ST(trig_holdoff_ms), holdoff_cb, NULL);
+  else
+    cmp_enable();
+}
+
+// arm for another capture; in single mode this is how the next one is taken
+void triggerArm(void) {
+
+  osalSysLock();
+  trig_running = 1;
+  last_capture_time = chVTGetSystemTimeX();
+  cmp_enable();
+  osalSysUnlock();
+}
+
+void triggerStart(void) {
+
+  triggerArm();
+}
+
+void triggerStop(void) {
+
+  osalSysLock();
+  trig_running = 0;
+  chVTResetI(&holdoff_vt);
+  cmp_disable();
+  CMP0->CR1 &= ~CMP_CR1_INV_MASK;
+  osalSysUnlock();
+}
+
+// equivalent time: the comparator output starts TPM1 itself, so no interrupt is armed
+void triggerStartTimer(void) {
+
+  triggerStop();
+
+  // the timer starts on a rising output, so invert it to start on falling edges
+  if( trig_edge == trigEdgeFalling )
+    CMP0->CR1 |= CMP_CR1_INV_MASK;
+}
+
+// called regularly from the UI thread, auto mode's free run lives here
+void triggerPoll(void) {
+
+  if( (trig_mode != trigModeAuto) || !trig_running )
+    return;
+
+  if( chVTTimeElapsedSinceX(last_capture_time) > TRIGGER_AUTO_TIMEOUT_ST ) {
+    osalSysLock();
+    trigger_fire_I();
+    osalSysUnlock();
+  }
+}
+
+void triggerSetEdge(trigger_edge edge) {
+
+  osalSysLock();
+  trig_edge = edge;
+  // takes effect now if armed, otherwise on the next rearm
+  if( trig_running && (CMP0->SCR & (CMP_SCR_IER_MASK | CMP_SCR_IEF_MASK)) )
+    CMP0->SCR = edge_bits() | CMP_SCR_CFR_MASK | CMP_SCR_CFF_MASK;
+  osalSysUnlock();
+}
+
+void triggerSetMode(trigger_mode mode) {
+
+  trig_mode = mode;
+}
+
+trigger_mode triggerGetMode(void) {
+
+  return trig_mode;
+}
+
+trigger_edge triggerGetEdge(void) {
+
+  return trig_edge;
+}
+
+// threshold in DAC steps, (vosel + 1) / 64 of VDD
+void triggerSetThreshold(uint8_t vosel) {
+
+  if( vosel > 63 )
+    vosel = 63;
+  trig_threshold = vosel;
+  CMP0->DACCR = CMP_DACCR_DACEN(1) | CMP_DACCR_VRSEL(1) | CMP_DACCR_VOSEL(trig_threshold);
+}
+
+uint8_t triggerGetThreshold(void) {
+
+  return trig_threshold;
+}
+
+// minimum time from one capture to arming for the next, 0 rearms right away
+void triggerSetHoldoff(uint16_t ms) {
+
+  trig_holdoff_ms = ms;
+}
+
+uint16_t triggerGetHoldoff(void) {
+
+  return trig_holdoff_ms;
+}
+
+const char *triggerEdgeName(trigger_edge edge) {
+
+  return edge_names[edge];
+}
+
+const char *triggerModeName(trigger_mode mode) {
+
+  return mode_names[mode];
+}
+
+void triggerPrintSettings(BaseSequentialStream *chp) {
+
+  chprintf(chp, "edge %s, mode %s, level %d (%d/64 VDD), holdoff %d ms\r\n",
+           edge_names[trig_edge], mode_names[trig_mode],
+           trig_threshold, trig_threshold + 1, trig_holdoff_ms);
+}
+
+OSAL_IRQ_HANDLER(Vector80) {
+  OSAL_IRQ_PROLOGUE();
+  osalSysLockFromISR();
+  trigger_fire_I();  // capture is continuous, this just marks where the edge landed
+  osalSysUnlockFromISR();
+  OSAL_IRQ_EPILOGUE();
+}
+
+void triggerInit(void) {
+
+  SIM->SCGC4 |= SIM_SCGC4_CMP;  // enable the CMP's clock
+  
+  // enable the DAC
+  // VRSEL = 1 means to use Vin2 which is VDD. Don't use VrefH because it causes crosstalk with ADC.
+  // set VOSEL = 31, so 31 + 1 / 64 = 0.5 * VDD, e.g. midpoint select for CMP.
+  // REVISION: due to crosstalk issues with self-sampling set threshold to
+  // VOSEL = 19, so 19 + 1 / 64 = 0.3125 * VDD ~ 1.05V for 3.3V VDD. 31.25% is also enough above
+  // Vol so that most proper CMOS signals should still trigger properly.
+  triggerSetThreshold(TRIGGER_THRESHOLD_DEFAULT);
+
+  CMP0->MUXCR = CMP_MUXCR_MSEL(7) | CMP_MUXCR_PSEL(0);  // 0 = CMP0_IN0, 7 = 6-bit DAC0 reference
+
+  // this should be sampled, filtered mode
+  //CMP0->CR0 = CMP_CR0_HYSTCTR(3) | CMP_CR0_FILTER_CNT(1); // 1 consecutive samples to agree
+  //CMP0->CR1 = CMP_CR1_EN(1) | CMP_CR1_PMODE(1);
+  //CMP0->FPR = CMP_FPR_FILT_PER(2); // filter at a rate of 12MHz (busclk = 24MHz / 2)
+
+  // continuous mode
+  CMP0->CR0 = CMP_CR0_HYSTCTR(3) | CMP_CR0_FILTER_CNT(0); 
+  CMP0->FPR = CMP_FPR_FILT_PER(0);
+  CMP0->CR1 = CMP_CR1_EN(1) | CMP_CR1_PMODE(1);
+
+  cmp_disable();
+  chVTObjectInit(&holdoff_vt);
+}
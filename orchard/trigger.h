@@ -0,0 +1,39 @@
+#ifndef __TRIGGER_H__
+#define __TRIGGER_H__
+
+typedef enum _trigger_edge {
+  trigEdgeRising = 0,
+  trigEdgeFalling,
+  trigEdgeBoth,
+} trigger_edge;
+
+typedef enum _trigger_mode {
+  trigModeAuto = 0,   // like normal, but forces a capture if nothing triggers for a while
+  trigModeNormal,     // only capture on a real edge
+  trigModeSingle,     // capture once, then wait for triggerArm()
+} trigger_mode;
+
+#define TRIGGER_THRESHOLD_DEFAULT  19             // DAC steps, (19 + 1) / 64 * VDD ~ 1.05V
+#define TRIGGER_AUTO_TIMEOUT_ST    MS2ST(1000)    // auto mode: force a capture after this long
+
+void triggerInit(void);
+void triggerStart(void);
+void triggerStop(void);
+void triggerStartTimer(void);
+void triggerArm(void);
+void triggerRearmI(void);
+void triggerPoll(void);
+
+void triggerSetEdge(trigger_edge edge);
+void triggerSetMode(trigger_mode mode);
+void triggerSetThreshold(uint8_t vosel);
+void triggerSetHoldoff(uint16_t ms);
+trigger_mode triggerGetMode(void);
+trigger_edge triggerGetEdge(void);
+uint8_t triggerGetThreshold(void);
+uint16_t triggerGetHoldoff(void);
+const char *triggerEdgeName(trigger_edge edge);
+const char *triggerModeName(trigger_mode mode);
+void triggerPrintSettings(BaseSequentialStream *chp);
+
+#endif /* __TRIGGER_H__ */
@@ -236,7 +236,7 @@ typedef struct
   __IO uint32_t CSR;
   __IO uint32_t PSR;
   __IO uint32_t CMR;
-  __I  uint32_t CNR;
+  __IO uint32_t CNR;            // written to latch the count before reading
 } LPTMR_TypeDef;
 
 typedef struct
@@ -590,6 +590,18 @@ typedef struct {
 #define SIM_SOPT2_CLKOUTSEL(x)       ((uint32_t)(((uint32_t)(x) << SIM_SOPT2_CLKOUTSEL_SHIFT) & SIM_SOPT2_CLKOUTSEL_MASK))  /*!< CLKOUT select */
 #define SIM_SOPT2_RTCCLKOUTSEL       ((uint32_t)0x00000010)    /*!< RTC clock out select */
 
+/*******  Bits definition for SIM_SOPT7 register  ************/
+#define SIM_SOPT7_ADC0ALTTRGEN       ((uint32_t)0x00000080)    /*!< ADC0 alternate trigger enable */
+#define SIM_SOPT7_ADC0PRETRGSEL      ((uint32_t)0x00000010)    /*!< ADC0 pretrigger select */
+#define SIM_SOPT7_ADC0TRGSEL_SHIFT   0                                                                                      /*!< ADC0 trigger select (shift) */
+#define SIM_SOPT7_ADC0TRGSEL_MASK    ((uint32_t)((uint32_t)0x0F << SIM_SOPT7_ADC0TRGSEL_SHIFT))                             /*!< ADC0 trigger select (mask) */
+#define SIM_SOPT7_ADC0TRGSEL(x)      ((uint32_t)(((uint32_t)(x) << SIM_SOPT7_ADC0TRGSEL_SHIFT) & SIM_SOPT7_ADC0TRGSEL_MASK))  /*!< ADC0 trigger select */
+#define SIM_SOPT7_ADC0TRGSEL_EXTRG   0                         /*!< EXTRG_IN pin */
+#define SIM_SOPT7_ADC0TRGSEL_CMP0    1                         /*!< CMP0 output */
+#define SIM_SOPT7_ADC0TRGSEL_TPM0    8                         /*!< TPM0 overflow */
+#define SIM_SOPT7_ADC0TRGSEL_TPM1    9                         /*!< TPM1 overflow */
+#define SIM_SOPT7_ADC0TRGSEL_LPTMR0  14                        /*!< LPTMR0 trigger */
+
 /*******  Bits definition for SIM_SCGC4 register  ************/
 #define SIM_SCGC4_SPI1               ((uint32_t)0x00800000)    /*!< SPI1 Clock Gate Control */
 #define SIM_SCGC4_SPI0               ((uint32_t)0x00400000)    /*!< SPI0 Clock Gate Control */
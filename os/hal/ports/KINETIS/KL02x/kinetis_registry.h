@@ -48,6 +48,9 @@
 /* SPI attributes.*/
 #define KINETIS_SPI0_IRQ_VECTOR     Vector68
 
+/* LPTMR attributes.*/
+#define KINETIS_LPTMR0_IRQ_VECTOR   VectorB0
+
 /** @} */
 
 #endif /* _KINETIS_REGISTRY_H_ */
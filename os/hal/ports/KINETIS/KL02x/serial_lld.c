@@ -60,7 +60,10 @@ SerialDriver SD3;
  * @brief   Driver default configuration.
  */
 static const SerialConfig default_config = {
-  38400
+  38400,
+#if KINETIS_SERIAL_USE_RX_EVENTS
+  0
+#endif
 };
 
 /*===========================================================================*/
@@ -76,8 +79,6 @@ static const SerialConfig default_config = {
  * @param[in] u         pointer to an UART I/O block
  * @param[in] sdp       communication channel associated to the UART
  */
-extern event_source_t serial_event;
-extern uint8_t serial_init;
 static void serve_interrupt(SerialDriver *sdp) {
   UARTLP_TypeDef *u = sdp->uart;
 
@@ -87,10 +88,12 @@ static void serve_interrupt(SerialDriver *sdp) {
       chnAddFlagsI(sdp, CHN_INPUT_AVAILABLE);
     if (iqPutI(&sdp->iqueue, u->D) < Q_OK)
       chnAddFlagsI(sdp, SD_OVERRUN_ERROR);
-    
-    if(serial_init)
-      chEvtBroadcastI(&serial_event); // instrument the serial handler to call our event loop
-    
+#if KINETIS_SERIAL_USE_RX_EVENTS
+    /* Only on the crossing, a consumer draining slower than the line
+       still gets a single wakeup.*/
+    if (iqGetFullI(&sdp->iqueue) == sdp->rx_watermark)
+      chnAddFlagsI(sdp, SD_RX_WATERMARK);
+#endif
     osalSysUnlockFromISR();
   }
 
@@ -111,8 +114,17 @@ static void serve_interrupt(SerialDriver *sdp) {
     }
   }
 
-  if (u->S1 & UARTx_S1_IDLE)
+  if (u->S1 & UARTx_S1_IDLE) {
     u->S1 = UARTx_S1_IDLE;  // Clear IDLE (S1 bits are write-1-to-clear).
+#if KINETIS_SERIAL_USE_RX_EVENTS
+    /* IDLE only sets again after another character, so this fires once
+       at the end of each burst.*/
+    osalSysLockFromISR();
+    if (!iqIsEmptyI(&sdp->iqueue))
+      chnAddFlagsI(sdp, SD_RX_IDLE);
+    osalSysUnlockFromISR();
+#endif
+  }
 
   if (u->S1 & (UARTx_S1_OR | UARTx_S1_NF | UARTx_S1_FE | UARTx_S1_PF)) {
     // FIXME: need to add set_error()
@@ -204,6 +216,12 @@ static void configure_uart(UARTLP_TypeDef *uart, const SerialConfig *config)
   uart->BDL = (divisor & UARTx_BDL_SBR);
 
   uart->C2 = UARTx_C2_RE | UARTx_C2_RIE | UARTx_C2_TE;
+#if KINETIS_SERIAL_USE_RX_EVENTS
+  /* Count idle time from the stop bit so trailing ones in the last
+     character don't end a burst early.*/
+  uart->C1 |= UARTx_C1_ILT;
+  uart->C2 |= UARTx_C2_ILIE;
+#endif
 }
 
 /*===========================================================================*/
@@ -282,6 +300,12 @@ void sd_lld_start(SerialDriver *sdp, const SerialConfig *config) {
   if (config == NULL)
     config = &default_config;
 
+#if KINETIS_SERIAL_USE_RX_EVENTS
+  sdp->rx_watermark = config->sc_rx_watermark;
+#else
+  sdp->rx_watermark = 0;
+#endif
+
   if (sdp->state == SD_STOP) {
     /* Enables the peripheral.*/
 
@@ -31,6 +31,20 @@
 /* Driver constants.                                                         */
 /*===========================================================================*/
 
+/**
+ * @name    KL02x specific channel flags
+ * @{
+ */
+/**
+ * @brief   The receiver saw an idle line with data waiting in the queue.
+ */
+#define SD_RX_IDLE              (eventflags_t)1024
+/**
+ * @brief   The input queue filled up to the configured watermark.
+ */
+#define SD_RX_WATERMARK         (eventflags_t)2048
+/** @} */
+
 /*===========================================================================*/
 /* Driver pre-compile time settings.                                         */
 /*===========================================================================*/
@@ -61,6 +75,18 @@
 #define KINETIS_SERIAL_USE_UART2             FALSE
 #endif
 
+/**
+ * @brief   Receive burst signalling switch.
+ * @details If set to @p TRUE the driver raises @p SD_RX_IDLE when the line
+ *          goes idle after a burst and @p SD_RX_WATERMARK when the input
+ *          queue reaches @p sc_rx_watermark, so an application can register
+ *          for those flags and wake once per burst rather than once per
+ *          byte.
+ */
+#if !defined(KINETIS_SERIAL_USE_RX_EVENTS) || defined(__DOXYGEN__)
+#define KINETIS_SERIAL_USE_RX_EVENTS         FALSE
+#endif
+
 /**
  * @brief   UART0 interrupt priority level setting.
  */
@@ -105,6 +131,13 @@ typedef struct {
    */
   uint32_t                  sc_speed;
   /* End of the mandatory fields.*/
+#if KINETIS_SERIAL_USE_RX_EVENTS || defined(__DOXYGEN__)
+  /**
+   * @brief Input queue fill level that raises @p SD_RX_WATERMARK.
+   * @note  Zero disables the watermark, idle detection is always on.
+   */
+  uint8_t                   sc_rx_watermark;
+#endif
 } SerialConfig;
 
 /**
@@ -124,7 +157,9 @@ typedef struct {
   uint8_t                   ob[SERIAL_BUFFER_TX_SIZE];                      \
   /* End of the mandatory fields.*/                                         \
   /* Pointer to the UART registers block.*/                                 \
-  UARTLP_TypeDef            *uart;
+  UARTLP_TypeDef            *uart;                                          \
+  /* Input queue fill level raising SD_RX_WATERMARK, zero if disabled.*/    \
+  uint8_t                   rx_watermark;
 
 /*===========================================================================*/
 /* Driver macros.                                                            */
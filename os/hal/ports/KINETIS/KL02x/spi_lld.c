@@ -71,6 +71,62 @@ static void spi_fill_buffer(SPIDriver *spip)
     spip->txoffset++;
 }
 
+static bool spi_use_polled(SPIDriver *spip)
+{
+  size_t max = spip->config->polled_max;
+
+  if (max == 0)
+    max = KINETIS_SPI_POLLED_MAX_DEFAULT;
+
+  switch (spip->config->xfer_mode) {
+  case KINETIS_SPI_XFER_POLLED_TX:
+    if (spip->rxbuf == NULL)
+      return true;
+    /* Falls through.*/
+  case KINETIS_SPI_XFER_POLLED:
+    return spip->count <= max;
+  default:
+    return false;
+  }
+}
+
+/*
+ * Moves all but the last frame by polling, with the system locked by the
+ * caller. The receive interrupt of the last frame then completes the
+ * transfer, so the calling thread is woken the same way as in IRQ mode and
+ * only one interrupt is taken.
+ */
+static void spi_polled_xfer(SPIDriver *spip)
+{
+  SPI_TypeDef *spi = spip->spi;
+  size_t last = spip->count - 1;
+
+  while (spip->rxoffset < last) {
+    /* At most one frame in the buffer and one in the shifter, otherwise
+       an unread receive would get overwritten.*/
+    if ((spip->txoffset < spip->count) &&
+        ((spip->txoffset - spip->rxoffset) < 2) &&
+        (spi->S & SPIx_S_SPTEF))
+      spi_fill_buffer(spip);
+
+    if (spi->S & SPIx_S_SPRF) {
+      if (spip->rxbuf)
+        spip->rxbuf[spip->rxoffset] = spi->D;
+      else
+        (void)spi->D;
+      spip->rxoffset++;
+    }
+  }
+
+  while (spip->txoffset < spip->count) {
+    while (!(spi->S & SPIx_S_SPTEF))
+      ;
+    spi_fill_buffer(spip);
+  }
+
+  spi->C1 |= SPIx_C1_SPIE;
+}
+
 static void spi_start_xfer(SPIDriver *spip)
 {
 
@@ -82,7 +138,14 @@ static void spi_start_xfer(SPIDriver *spip)
 
   spip->txoffset = 0;
   spip->rxoffset = 0;
-  spip->spi->C1 |= SPIx_C1_SPIE | SPIx_C1_SPTIE;
+
+  if (spi_use_polled(spip)) {
+    spi_polled_xfer(spip);
+    return;
+  }
+
+  /* Driven by the receive interrupt alone, one frame at a time.*/
+  spip->spi->C1 |= SPIx_C1_SPIE;
 
   spi_fill_buffer(spip);
 }
@@ -100,22 +163,35 @@ static void spi_stop_xfer(SPIDriver *spip)
 
 static void spi_handle_isr(SPIDriver *spip)
 {
+  SPI_TypeDef *spi = spip->spi;
 
   osalDbgAssert(spip->state == SPI_ACTIVE, "Invalid SPI state");
 
-  while ((spip->rxoffset < spip->count) && (spip->spi->S & SPIx_S_SPRF)) {
-    if ((spip->rxbuf) && (spip->rxoffset < spip->count))
-      spip->rxbuf[spip->rxoffset] = spip->spi->D;
-    else
-      (void)spip->spi->D;
-    spip->rxoffset++;
+  /* Send-only transfers just drop what comes back, SPRF still has to be
+     cleared by reading D.*/
+  if (spip->rxbuf == NULL) {
+    while ((spip->rxoffset < spip->count) && (spi->S & SPIx_S_SPRF)) {
+      (void)spi->D;
+      spip->rxoffset++;
+    }
+  }
+  else {
+    while ((spip->rxoffset < spip->count) && (spi->S & SPIx_S_SPRF)) {
+      spip->rxbuf[spip->rxoffset] = spi->D;
+      spip->rxoffset++;
+    }
   }
 
   if (spip->rxoffset >= spip->count) {
     spi_stop_xfer(spip);
     _spi_isr_code(spip);
   }
-  else if (spip->txoffset < spip->count) {
+  else if (spip->txoffset == spip->rxoffset) {
+    /* Only one frame is ever in flight. With a second one queued behind
+       the shifter, an interrupt latency longer than one frame time lets
+       it complete while SPRF is still set and its receive is lost, so
+       rxoffset would never reach count. The previous frame has been read
+       back, so the transmit buffer is empty here.*/
     spi_fill_buffer(spip);
   }
 }
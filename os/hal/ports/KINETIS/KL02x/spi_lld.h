@@ -31,6 +31,27 @@
 /* Driver constants.                                                         */
 /*===========================================================================*/
 
+/**
+ * @name    Transfer strategies
+ * @{
+ */
+/**
+ * @brief   Every frame is moved by the SPI interrupt.
+ */
+#define KINETIS_SPI_XFER_IRQ                  0
+/**
+ * @brief   Transfers up to @p polled_max frames are polled.
+ * @details All but the last frame are moved with the system locked, the
+ *          receive interrupt of the last frame completes the transfer.
+ */
+#define KINETIS_SPI_XFER_POLLED               1
+/**
+ * @brief   Like @p KINETIS_SPI_XFER_POLLED, and send-only transfers of any
+ *          length are polled too.
+ */
+#define KINETIS_SPI_XFER_POLLED_TX            2
+/** @} */
+
 /*===========================================================================*/
 /* Driver pre-compile time settings.                                         */
 /*===========================================================================*/
@@ -70,6 +91,19 @@
 #define KINETIS_SPI_SPI1_IRQ_PRIORITY         2
 #endif
 
+/**
+ * @brief   Default polled transfer length limit, in frames.
+ * @details At the 6MHz SCK set up by @p spi_lld_start() a frame takes about
+ *          64 core cycles, less than the M0+ exception entry/exit plus the
+ *          OSAL prologue/epilogue and handler, so the interrupt path can't
+ *          keep the bus busy and every transfer also pays a thread wakeup.
+ *          Polling is limited by how long interrupts stay masked: 16 frames
+ *          is about 21us.
+ */
+#if !defined(KINETIS_SPI_POLLED_MAX_DEFAULT) || defined(__DOXYGEN__)
+#define KINETIS_SPI_POLLED_MAX_DEFAULT        16
+#endif
+
 /*===========================================================================*/
 /* Derived constants and error checks.                                       */
 /*===========================================================================*/
@@ -123,6 +157,15 @@ typedef struct {
    * @brief The chip select line pad number - when not using pcs.
    */
   uint16_t                  sspad;
+  /**
+   * @brief Transfer strategy, one of the @p KINETIS_SPI_XFER_* values.
+   */
+  uint8_t                   xfer_mode;
+  /**
+   * @brief Longest transfer, in frames, that is polled or zero for
+   *        @p KINETIS_SPI_POLLED_MAX_DEFAULT.
+   */
+  uint16_t                  polled_max;
 } SPIConfig;
 
 /**
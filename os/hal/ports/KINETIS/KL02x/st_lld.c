@@ -30,6 +30,56 @@
 /* Driver local definitions.                                                 */
 /*===========================================================================*/
 
+#if (OSAL_ST_MODE == OSAL_ST_MODE_FREERUNNING) || defined(__DOXYGEN__)
+/* The LPTMR counts one system tick per (prescaled) clock.*/
+#if OSAL_ST_FREQUENCY != KINETIS_ST_LPTMR_FREQUENCY
+#error "OSAL_ST_FREQUENCY must match KINETIS_ST_LPTMR_FREQUENCY"
+#endif
+
+/**
+ * @brief   LPTMR prescaler register setting.
+ */
+#if (KINETIS_ST_LPTMR_PRESCALE == 0) || defined(__DOXYGEN__)
+#define LPTMR_PSR           (LPTMRx_PSR_PCS(KINETIS_ST_LPTMR_SOURCE) |      \
+                             LPTMRx_PSR_PBYP)
+#else
+#define LPTMR_PSR           (LPTMRx_PSR_PCS(KINETIS_ST_LPTMR_SOURCE) |      \
+                             LPTMRx_PSR_PRESCALE(KINETIS_ST_LPTMR_PRESCALE - 1))
+#endif
+
+/**
+ * @brief   LPTMR control while running: free-running counter, IRQ enabled.
+ */
+#define LPTMR_CSR_RUN       (LPTMRx_CSR_TEN | LPTMRx_CSR_TFC | LPTMRx_CSR_TIE)
+
+/**
+ * @brief   Longest gap between compares, so no counter wrap goes unseen.
+ */
+#define LPTMR_MAX_STRIDE    ((systime_t)0x8000)
+
+/**
+ * @brief   Shortest lead a compare is programmed with.
+ * @details CMR and CSR writes reach the counter through its clock domain
+ *          synchronizer, so a compare one count ahead can already have
+ *          passed when it takes effect.
+ */
+#if (CH_CFG_ST_TIMEDELTA > 2) || defined(__DOXYGEN__)
+#define LPTMR_MIN_LEAD      ((systime_t)CH_CFG_ST_TIMEDELTA)
+#else
+#define LPTMR_MIN_LEAD      ((systime_t)2)
+#endif
+
+/**
+ * @brief   Counts lost, on average, each time the counter is restarted.
+ * @details Disabling the LPTMR resets CNR, dropping the count in progress,
+ *          uniform over [0, 1). After enabling, the first increment takes
+ *          one or two extra prescaler clocks to synchronize (reference
+ *          manual, LPTMR counter section). The loss is therefore in [1, 3)
+ *          counts, mean 2, standard deviation under 0.6 counts.
+ */
+#define LPTMR_RESTART_LOSS  ((systime_t)2)
+#endif /* OSAL_ST_MODE == OSAL_ST_MODE_FREERUNNING */
+
 /*===========================================================================*/
 /* Driver exported variables.                                                */
 /*===========================================================================*/
@@ -42,10 +92,141 @@
 /* Driver local variables and types.                                         */
 /*===========================================================================*/
 
+#if (OSAL_ST_MODE == OSAL_ST_MODE_FREERUNNING) || defined(__DOXYGEN__)
+/**
+ * @brief   System time at the last counter restart, plus any wraps since.
+ */
+static systime_t st_high;
+
+/**
+ * @brief   Last LPTMR count seen, for wrap detection.
+ */
+static uint16_t st_last;
+
+/**
+ * @brief   System time the compare register currently stands for.
+ */
+static systime_t st_compare;
+
+/**
+ * @brief   Current alarm time.
+ */
+static systime_t st_alarm;
+
+/**
+ * @brief   Alarm enabled flag.
+ */
+static bool st_alarm_active;
+#endif /* OSAL_ST_MODE == OSAL_ST_MODE_FREERUNNING */
+
 /*===========================================================================*/
 /* Driver local functions.                                                   */
 /*===========================================================================*/
 
+#if (OSAL_ST_MODE == OSAL_ST_MODE_FREERUNNING) || defined(__DOXYGEN__)
+/**
+ * @brief   Reads the LPTMR counter.
+ * @note    The counter must be written before each read, which latches
+ *          the current count into CNR.
+ */
+static uint16_t lptmr_read(void) {
+
+  LPTMR0->CNR = 0;
+  return (uint16_t)LPTMR0->CNR;
+}
+
+/**
+ * @brief   Extends the 16 bits LPTMR counter to a system time.
+ * @note    Must be called with the system locked.
+ */
+static systime_t lptmr_now(void) {
+  uint16_t cnt = lptmr_read();
+
+  if (cnt < st_last) {
+    st_high += (systime_t)0x10000;
+  }
+  st_last = cnt;
+
+  return st_high + cnt;
+}
+
+/**
+ * @brief   Ticks from @p now to @p time, zero if it is already due.
+ */
+static systime_t lptmr_delta(systime_t now, systime_t time) {
+
+  if ((systime_t)(now - time) < LPTMR_MAX_STRIDE) {
+    return (systime_t)0;
+  }
+  return time - now;
+}
+
+/**
+ * @brief   Compare value for the next interrupt, the alarm if it is near
+ *          enough, otherwise a wrap keeping stride.
+ */
+static uint16_t lptmr_next_compare(systime_t now) {
+  systime_t delta = LPTMR_MAX_STRIDE;
+
+  if (st_alarm_active && (lptmr_delta(now, st_alarm) < LPTMR_MAX_STRIDE)) {
+    delta = lptmr_delta(now, st_alarm);
+    if (delta < LPTMR_MIN_LEAD) {
+      delta = LPTMR_MIN_LEAD;
+    }
+  }
+
+  st_compare = now + delta;
+  return (uint16_t)(st_last + delta);
+}
+
+/**
+ * @brief   Restarts the counter with a fresh compare.
+ * @note    The only way to move a compare while TCF is clear. The error
+ *          left by @p LPTMR_RESTART_LOSS is zero mean, so restarts add a
+ *          random walk of about 0.6 * sqrt(restarts) counts rather than a
+ *          drift: at 100 restarts per second that is under 1ppm, against
+ *          +/-30ppm for a typical 32kHz crystal.
+ */
+static void lptmr_restart(systime_t now) {
+
+  LPTMR0->CSR = 0;
+  st_high = now + LPTMR_RESTART_LOSS;
+  st_last = 0;
+  LPTMR0->CMR = lptmr_next_compare(st_high);
+  LPTMR0->CSR = LPTMR_CSR_RUN;
+}
+
+/**
+ * @brief   Programs the compare register.
+ * @note    CMR can only be written while TCF is set or the timer is
+ *          disabled. With TCF set the compare is moved and the flag
+ *          cleared. A compare the counter reached before the flag was
+ *          cleared would only match again a whole counter period later,
+ *          so the counter is read back and restarted in that case. With
+ *          TCF clear the pending compare is kept when it comes no later
+ *          than the alarm, its interrupt moves on to the alarm. Only an
+ *          alarm before the pending compare restarts the counter.
+ */
+static void lptmr_program(void) {
+  systime_t now = lptmr_now();
+
+  if ((LPTMR0->CSR & LPTMRx_CSR_TCF) != 0U) {
+    LPTMR0->CMR = lptmr_next_compare(now);
+    LPTMR0->CSR = LPTMR_CSR_RUN | LPTMRx_CSR_TCF;
+    now = lptmr_now();
+    if (lptmr_delta(now, st_compare) == (systime_t)0) {
+      lptmr_restart(now);
+    }
+  }
+  else if (lptmr_delta(now, st_compare) <= lptmr_delta(now, st_alarm)) {
+    /* The compare comes first anyway.*/
+  }
+  else {
+    lptmr_restart(now);
+  }
+}
+#endif /* OSAL_ST_MODE == OSAL_ST_MODE_FREERUNNING */
+
 /*===========================================================================*/
 /* Driver interrupt handlers.                                                */
 /*===========================================================================*/
@@ -69,6 +250,43 @@ OSAL_IRQ_HANDLER(SysTick_Handler) {
 }
 #endif /* OSAL_ST_MODE == OSAL_ST_MODE_PERIODIC */
 
+#if (OSAL_ST_MODE == OSAL_ST_MODE_FREERUNNING) || defined(__DOXYGEN__)
+/**
+ * @brief   LPTMR vector.
+ * @details This interrupt is used for the alarm in free-running mode, and
+ *          at least once every @p LPTMR_MAX_STRIDE ticks to track the
+ *          counter wrapping.
+ *
+ * @isr
+ */
+OSAL_IRQ_HANDLER(KINETIS_LPTMR0_IRQ_VECTOR) {
+  systime_t now;
+
+  OSAL_IRQ_PROLOGUE();
+
+  osalSysLockFromISR();
+  now = lptmr_now();
+  if (((LPTMR0->CSR & LPTMRx_CSR_TCF) != 0U) &&
+      (lptmr_delta(now, st_compare) != (systime_t)0)) {
+    /* The counter has reached the compare, a time still before it means
+       a whole counter period went by unseen.*/
+    st_high += (systime_t)0x10000;
+    now += (systime_t)0x10000;
+  }
+  if (st_alarm_active && ((systime_t)(now - st_alarm) < LPTMR_MAX_STRIDE)) {
+    osalOsTimerHandlerI();
+  }
+
+  /* Moves the compare and clears TCF. The flag is already clear when a
+     thread reprogrammed the timer while this interrupt was pending, the
+     compare that thread set is then kept.*/
+  lptmr_program();
+  osalSysUnlockFromISR();
+
+  OSAL_IRQ_EPILOGUE();
+}
+#endif /* OSAL_ST_MODE == OSAL_ST_MODE_FREERUNNING */
+
 /*===========================================================================*/
 /* Driver exported functions.                                                */
 /*===========================================================================*/
@@ -91,7 +309,117 @@ void st_lld_init(void) {
   /* IRQ enabled.*/
   nvicSetSystemHandlerPriority(HANDLER_SYSTICK, KINETIS_ST_IRQ_PRIORITY);
 #endif /* OSAL_ST_MODE == OSAL_ST_MODE_PERIODIC */
+
+#if OSAL_ST_MODE == OSAL_ST_MODE_FREERUNNING
+  /* Free-running mode, the LPTMR keeps counting in the low power modes,
+     and so must its clock.*/
+#if KINETIS_ST_LPTMR_SOURCE == KINETIS_ST_LPTMR_MCGIRCLK
+  MCG->C2 &= ~MCG_C2_IRCS;
+  MCG->C1 |= MCG_C1_IRCLKEN | MCG_C1_IREFSTEN;
+#elif KINETIS_ST_LPTMR_SOURCE == KINETIS_ST_LPTMR_OSCERCLK
+  OSC0->CR |= OSC_CR_ERCLKEN | OSC_CR_EREFSTEN;
+#endif
+  SIM->SCGC5 |= SIM_SCGC5_LPTMR;
+  LPTMR0->CSR = 0;
+  LPTMR0->PSR = LPTMR_PSR;
+
+  st_high = 0;
+  st_last = 0;
+  st_compare = LPTMR_MAX_STRIDE;
+  st_alarm_active = false;
+  LPTMR0->CMR = (uint16_t)LPTMR_MAX_STRIDE;
+  LPTMR0->CSR = LPTMR_CSR_RUN;
+
+  /* IRQ enabled.*/
+  nvicEnableVector(LPTMR0_IRQn, KINETIS_ST_IRQ_PRIORITY);
+#endif /* OSAL_ST_MODE == OSAL_ST_MODE_FREERUNNING */
+}
+
+#if (OSAL_ST_MODE == OSAL_ST_MODE_FREERUNNING) || defined(__DOXYGEN__)
+/**
+ * @brief   Returns the time counter value.
+ *
+ * @return              The counter value.
+ *
+ * @notapi
+ */
+systime_t st_lld_get_counter(void) {
+  syssts_t sts;
+  systime_t now;
+
+  sts = osalSysGetStatusAndLockX();
+  now = lptmr_now();
+  osalSysRestoreStatusX(sts);
+
+  return now;
+}
+
+/**
+ * @brief   Starts the alarm.
+ * @note    Makes sure that no spurious alarms are triggered after
+ *          this call.
+ *
+ * @param[in] time      the time to be set for the first alarm
+ *
+ * @notapi
+ */
+void st_lld_start_alarm(systime_t time) {
+
+  st_lld_set_alarm(time);
+}
+
+/**
+ * @brief   Stops the alarm interrupt.
+ * @note    The LPTMR interrupt keeps firing every @p LPTMR_MAX_STRIDE
+ *          ticks to track the counter.
+ *
+ * @notapi
+ */
+void st_lld_stop_alarm(void) {
+
+  st_alarm_active = false;
+}
+
+/**
+ * @brief   Sets the alarm time.
+ *
+ * @param[in] time      the time to be set for the next alarm
+ *
+ * @notapi
+ */
+void st_lld_set_alarm(systime_t time) {
+
+  st_alarm = time;
+  st_alarm_active = true;
+  lptmr_program();
+}
+
+/**
+ * @brief   Returns the current alarm time.
+ *
+ * @return              The currently set alarm time.
+ *
+ * @notapi
+ */
+systime_t st_lld_get_alarm(void) {
+
+  return st_alarm;
+}
+
+/**
+ * @brief   Determines if the alarm is active.
+ *
+ * @return              The alarm status.
+ * @retval false        if the alarm is not active.
+ * @retval true         is the alarm is active
+ *
+ * @notapi
+ */
+bool st_lld_is_alarm_active(void) {
+
+  return st_alarm_active;
 }
+#endif /* OSAL_ST_MODE == OSAL_ST_MODE_FREERUNNING */
 
 #endif /* OSAL_ST_MODE != OSAL_ST_MODE_NONE */
 
@@ -33,6 +33,15 @@
 /* Driver constants.                                                         */
 /*===========================================================================*/
 
+/**
+ * @name    LPTMR clock sources
+ * @{
+ */
+#define KINETIS_ST_LPTMR_MCGIRCLK             0   /**< Slow internal reference.*/
+#define KINETIS_ST_LPTMR_LPO                  1   /**< 1kHz LPO, untrimmed.    */
+#define KINETIS_ST_LPTMR_OSCERCLK             3   /**< External crystal.       */
+/** @} */
+
 /*===========================================================================*/
 /* Driver pre-compile time settings.                                         */
 /*===========================================================================*/
@@ -42,18 +51,62 @@
  * @{
  */
 /**
- * @brief   SysTick timer IRQ priority.
+ * @brief   System timer IRQ priority.
+ * @note    SysTick in periodic mode, LPTMR0 in free-running mode.
  */
 #if !defined(KINETIS_ST_IRQ_PRIORITY) || defined(__DOXYGEN__)
 #define KINETIS_ST_IRQ_PRIORITY               8
 #endif
 
+/**
+ * @brief   LPTMR clock source in free-running mode.
+ * @details The crystal when the MCG runs from one, otherwise the factory
+ *          trimmed slow internal reference. The LPO is off by as much as
+ *          +/-40%, so it is only good as a last resort.
+ */
+#if !defined(KINETIS_ST_LPTMR_SOURCE) || defined(__DOXYGEN__)
+#if (KINETIS_MCG_MODE == KINETIS_MCG_MODE_FEI) || defined(__DOXYGEN__)
+#define KINETIS_ST_LPTMR_SOURCE               KINETIS_ST_LPTMR_MCGIRCLK
+#else
+#define KINETIS_ST_LPTMR_SOURCE               KINETIS_ST_LPTMR_OSCERCLK
+#endif
+#endif
+
+/**
+ * @brief   Frequency of the LPTMR clock source.
+ */
+#if !defined(KINETIS_ST_LPTMR_SOURCE_FREQUENCY) || defined(__DOXYGEN__)
+#if (KINETIS_ST_LPTMR_SOURCE == KINETIS_ST_LPTMR_LPO) && !defined(__DOXYGEN__)
+#define KINETIS_ST_LPTMR_SOURCE_FREQUENCY     1000
+#else
+#define KINETIS_ST_LPTMR_SOURCE_FREQUENCY     32768
+#endif
+#endif
+
+/**
+ * @brief   LPTMR prescaler, the source is divided by 2^N.
+ * @note    Zero bypasses the prescaler. Every restart of the counter loses
+ *          a fraction of a prescaled count, so prefer a small value.
+ */
+#if !defined(KINETIS_ST_LPTMR_PRESCALE) || defined(__DOXYGEN__)
+#define KINETIS_ST_LPTMR_PRESCALE             0
+#endif
 /** @} */
 
 /*===========================================================================*/
 /* Derived constants and error checks.                                       */
 /*===========================================================================*/
 
+#if (KINETIS_ST_LPTMR_PRESCALE < 0) || (KINETIS_ST_LPTMR_PRESCALE > 16)
+#error "KINETIS_ST_LPTMR_PRESCALE out of range (0..16)"
+#endif
+
+/**
+ * @brief   LPTMR count rate, one count per system tick.
+ */
+#define KINETIS_ST_LPTMR_FREQUENCY                                          \
+  (KINETIS_ST_LPTMR_SOURCE_FREQUENCY >> KINETIS_ST_LPTMR_PRESCALE)
+
 /*===========================================================================*/
 /* Driver data structures and types.                                         */
 /*===========================================================================*/
@@ -70,6 +123,14 @@
 extern "C" {
 #endif
   void st_lld_init(void);
+#if (OSAL_ST_MODE == OSAL_ST_MODE_FREERUNNING) || defined(__DOXYGEN__)
+  systime_t st_lld_get_counter(void);
+  void st_lld_start_alarm(systime_t time);
+  void st_lld_stop_alarm(void);
+  void st_lld_set_alarm(systime_t time);
+  systime_t st_lld_get_alarm(void);
+  bool st_lld_is_alarm_active(void);
+#endif
 #ifdef __cplusplus
 }
 #endif
@@ -78,6 +139,7 @@ extern "C" {
 /* Driver inline functions.                                                  */
 /*===========================================================================*/
 
+#if OSAL_ST_MODE != OSAL_ST_MODE_FREERUNNING
 /**
  * @brief   Returns the time counter value.
  *
@@ -150,6 +212,7 @@ static inline bool st_lld_is_alarm_active(void) {
 
   return false;
 }
+#endif /* OSAL_ST_MODE != OSAL_ST_MODE_FREERUNNING */
 
 #endif /* _ST_LLD_H_ */
 
@@ -24,7 +24,6 @@
 
 #include "hal.h"
 
-void (*adcFastISR)(void);
 void (*adcISR)(void);
 
 #if HAL_USE_ADC || defined(__DOXYGEN__)
@@ -52,6 +51,13 @@ ADCDriver ADCD1;
 /* Driver local functions.                                                   */
 /*===========================================================================*/
 
+/**
+ * @brief   Starts the calibration sequence.
+ * @details Calibration takes several ms, so rather than busy waiting its
+ *          completion interrupt finishes it off in @p calibrate_done().
+ *
+ * @param[in] adcp      pointer to the @p ADCDriver object
+ */
 static void calibrate(ADCDriver *adcp) {
 
   /* Clock Divide by 8, Use Bus Clock Div 2 */
@@ -62,25 +68,69 @@ static void calibrate(ADCDriver *adcp) {
   /* Use software trigger and disable DMA etc. */
   adcp->adc->SC2 = 0;
 
+  /* Interrupt on completion, this must be written before CAL is set as
+     any SC1A write aborts a running calibration.*/
+  adcp->adc->SC1A = ADCx_SC1n_AIEN | ADCx_SC1n_ADCH(ADCx_SC1n_ADCH_DISABLED);
+
+  adcp->calibrating = true;
+
   /* Enable Hardware Average, Average 32 Samples, Calibrate */
   adcp->adc->SC3 = ADCx_SC3_AVGE |
       ADCx_SC3_AVGS(ADCx_SC3_AVGS_AVERAGE_32_SAMPLES) |
       ADCx_SC3_CAL;
+}
+
+/**
+ * @brief   Computes and caches the gains once calibration completes.
+ * @note    On failure the reset gains are left in place and nothing is
+ *          cached, so the next start calibrates again.
+ *
+ * @param[in] adcp      pointer to the @p ADCDriver object
+ */
+static void calibrate_done(ADCDriver *adcp) {
 
-  /* FIXME: May take several ms. Use an interrupt instead of busy wait */
-  /* Wait for calibration completion */
-  while (!(adcp->adc->SC1A & ADCx_SC1n_COCO))
-    ;
+  adcp->calibrating = false;
+
+  if (adcp->adc->SC3 & ADCx_SC3_CALF) {
+    /* CALF is write-1-to-clear.*/
+    adcp->adc->SC3 = ADCx_SC3_CALF;
+    return;
+  }
 
   uint16_t gain = ((adcp->adc->CLP0 + adcp->adc->CLP1 + adcp->adc->CLP2 +
       adcp->adc->CLP3 + adcp->adc->CLP4 + adcp->adc->CLPS) / 2) | 0x8000;
   adcp->adc->PG = gain;
+  adcp->cal_pg = gain;
 
   gain = ((adcp->adc->CLM0 + adcp->adc->CLM1 + adcp->adc->CLM2 +
       adcp->adc->CLM3 + adcp->adc->CLM4 + adcp->adc->CLMS) / 2) | 0x8000;
   adcp->adc->MG = gain;
+  adcp->cal_mg = gain;
+
+  /* The offset is written by the calibration itself.*/
+  adcp->cal_ofs = adcp->adc->OFS;
+  adcp->calibrated = true;
+}
+
+#if KINETIS_ADC_USE_CONTINUOUS || defined(__DOXYGEN__)
+/**
+ * @brief   Half and full buffer handling for the continuous path.
+ * @note    The converter keeps running, so unlike the software triggered
+ *          path nothing needs re-arming here.
+ *
+ * @param[in] adcp      pointer to the @p ADCDriver object
+ */
+static void serve_continuous_boundary(ADCDriver *adcp) {
 
+  if (adcp->current_index == adcp->number_of_samples) {
+    _adc_isr_full_code(adcp);
+    adcp->current_index = 0;
+  }
+  else if (adcp->grpp->circular) {
+    _adc_isr_half_code(adcp);
+  }
 }
+#endif
 
 /*===========================================================================*/
 /* Driver interrupt handlers.                                                */
@@ -93,16 +143,46 @@ static void calibrate(ADCDriver *adcp) {
  * @isr
  */
 OSAL_IRQ_HANDLER(KINETIS_ADC0_IRQ_VECTOR) {
-  if (adcFastISR) {
-    adcFastISR();
+#if KINETIS_ADC_USE_CONTINUOUS
+  if (ADCD1.continuous) {
+    ADCDriver *adcp = &ADCD1;
+    size_t i = adcp->current_index;
+
+    /* Reading RA clears COCO, the next conversion is already under way.*/
+    adcp->samples[i++] = adcp->adc->RA;
+    adcp->current_index = i;
+
+    /* Nothing for the kernel to do between callbacks, so skip the
+       prologue and epilogue entirely.*/
+    if ((i != adcp->number_of_samples) && (i != (adcp->number_of_samples / 2)))
+      return;
+
+    OSAL_IRQ_PROLOGUE();
+    serve_continuous_boundary(adcp);
+    OSAL_IRQ_EPILOGUE();
     return;
   }
+#endif
 
   OSAL_IRQ_PROLOGUE();
 
   if (adcISR) {
     adcISR();
   }
+  else if (ADCD1.calibrating) {
+    calibrate_done(&ADCD1);
+
+    /* Start a group that was waiting on the calibration, otherwise just
+       clear COCO and the interrupt enable.*/
+    if (ADCD1.grpp != NULL)
+      adc_lld_start_conversion(&ADCD1);
+    else
+      ADCD1.adc->SC1A = ADCx_SC1n_ADCH(ADCx_SC1n_ADCH_DISABLED);
+  }
+  else if (ADCD1.grpp == NULL) {
+    /* The conversion was stopped while this IRQ was already pending.*/
+    (void)ADCD1.adc->RA;
+  }
   else {
     ADCDriver *adcp = &ADCD1;
 
@@ -185,7 +265,16 @@ void adc_lld_start(ADCDriver *adcp) {
 #if KINETIS_ADC_USE_ADC0
     if (&ADCD1 == adcp) {
       adcp->adc = ADC0;
-      if (adcp->config->calibrate) {
+      adcp->adc->CFG2 = adcp->config->cfg2;
+      if (adcp->calibrated) {
+        /* Warm restart, the gains are still good.*/
+        adcp->adc->OFS = adcp->cal_ofs;
+        adcp->adc->PG = adcp->cal_pg;
+        adcp->adc->MG = adcp->cal_mg;
+      }
+      else if (adcp->config->calibrate) {
+        /* Returns straight away, conversions started meanwhile are held
+           until it completes.*/
         calibrate(adcp);
       }
     }
@@ -213,8 +302,10 @@ void adc_lld_stop(ADCDriver *adcp) {
       adcp->adc->SC2  = 0;
       adcp->adc->SC3  = 0;
 
-      /* Disable Interrupt, Disable Channel */
+      /* Disable Interrupt, Disable Channel. This also aborts an unfinished
+         calibration, which then runs again on the next start.*/
       adcp->adc->SC1A = ADCx_SC1n_ADCH(ADCx_SC1n_ADCH_DISABLED);
+      adcp->calibrating = false;
 
       osalSysUnlock();
     }
@@ -235,6 +326,10 @@ void adc_lld_stop(ADCDriver *adcp) {
 void adc_lld_start_conversion(ADCDriver *adcp) {
   const ADCConversionGroup *grpp = adcp->grpp;
 
+  /* The calibration completion interrupt starts the group instead.*/
+  if (adcp->calibrating)
+    return;
+
   /* Enable the Bandgap Buffer if channel mask includes BANDGAP */
   if (grpp->channel_mask & ADC_BANDGAP) {
     PMC->REGSC |= PMC_REGSC_BGBE;
@@ -255,6 +350,32 @@ void adc_lld_start_conversion(ADCDriver *adcp) {
   /* Set averaging */
   adcp->adc->SC3 = grpp->sc3;
 
+  /* Select the trigger, hardware triggers take effect on the SC1A write
+     below but don't start a conversion by themselves.*/
+  if (grpp->sopt7 != 0) {
+#if defined(SIM_SOPT7_ADC0ALTTRGEN)
+    SIM->SOPT7 = (SIM->SOPT7 & ~(SIM_SOPT7_ADC0ALTTRGEN |
+                                 SIM_SOPT7_ADC0PRETRGSEL |
+                                 SIM_SOPT7_ADC0TRGSEL_MASK)) | grpp->sopt7;
+#else
+    osalDbgAssert(false, "no SOPT7 trigger selection on this device");
+#endif
+    adcp->adc->SC2 |= ADCx_SC2_ADTRG;
+  }
+  else {
+    adcp->adc->SC2 &= ~ADCx_SC2_ADTRG;
+  }
+
+#if KINETIS_ADC_USE_CONTINUOUS
+  osalDbgAssert(!(grpp->sc3 & ADCx_SC3_ADCO) || (grpp->num_channels == 1),
+                "continuous conversion is single channel only");
+  adcp->continuous = (grpp->num_channels == 1) &&
+                     (((grpp->sc3 & ADCx_SC3_ADCO) != 0) || (grpp->sopt7 != 0));
+#else
+  osalDbgAssert(!(grpp->sc3 & ADCx_SC3_ADCO),
+                "KINETIS_ADC_USE_CONTINUOUS not enabled");
+#endif
+
   /* Enable Interrupt, Select Channel */
   adcp->adc->SC1A = ADCx_SC1n_AIEN | ADCx_SC1n_ADCH(adcp->current_channel);
 }
@@ -269,6 +390,23 @@ void adc_lld_start_conversion(ADCDriver *adcp) {
 void adc_lld_stop_conversion(ADCDriver *adcp) {
   const ADCConversionGroup *grpp = adcp->grpp;
 
+  /* Never actually started, and touching SC1A would abort calibration.*/
+  if (adcp->calibrating)
+    return;
+
+  /* Disable Interrupt, Disable Channel. Circular groups never finish on
+     their own so this is what actually halts them.*/
+  adcp->adc->SC1A = ADCx_SC1n_ADCH(ADCx_SC1n_ADCH_DISABLED);
+
+#if KINETIS_ADC_USE_CONTINUOUS
+  /* A still pending IRQ goes down the normal path, which drops it.*/
+  adcp->continuous = false;
+  adcp->adc->SC3 &= ~ADCx_SC3_ADCO;
+#endif
+
+  /* Back to software triggering for whoever converts next.*/
+  adcp->adc->SC2 &= ~ADCx_SC2_ADTRG;
+
   /* Disable the Bandgap buffer if channel mask includes BANDGAP */
   if (grpp->channel_mask & ADC_BANDGAP) {
     /* Clear BGBE, ACKISO is w1c, avoid setting */
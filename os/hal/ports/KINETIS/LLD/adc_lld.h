@@ -160,6 +160,19 @@
 #define KINETIS_ADC_IRQ_PRIORITY            5
 #endif
 
+/**
+ * @brief   Continuous conversion support.
+ * @details If set to @p TRUE, single channel groups that set
+ *          @p ADCx_SC3_ADCO in their @p sc3 field run with the converter
+ *          free running and are served by a short interrupt path that only
+ *          stores the result, entering the kernel just at the half and
+ *          full buffer callbacks. Single channel hardware triggered groups
+ *          use the same path, as they need no re-arm between samples either.
+ */
+#if !defined(KINETIS_ADC_USE_CONTINUOUS) || defined(__DOXYGEN__)
+#define KINETIS_ADC_USE_CONTINUOUS          FALSE
+#endif
+
 /** @} */
 
 /*===========================================================================*/
@@ -257,8 +270,18 @@ typedef struct {
   /**
    * @brief   ADC SC3 register initialization data.
    * @note    All the required bits must be defined into this field.
+   * @note    @p ADCx_SC3_ADCO requires @p KINETIS_ADC_USE_CONTINUOUS and
+   *          a single channel group.
    */
   uint32_t                  sc3;
+  /**
+   * @brief   SIM SOPT7 ADC0 trigger selection, see @p ADC_SOPT7_TRIGGER().
+   * @details Zero keeps the software trigger. Otherwise each trigger from
+   *          the selected source converts one channel, so the source sets
+   *          the sample rate, e.g. a TPM overflow at a fixed period.
+   * @note    The trigger source itself is set up by the application.
+   */
+  uint32_t                  sopt7;
 } ADCConversionGroup;
 
 /**
@@ -268,6 +291,12 @@ typedef struct {
 typedef struct {
   /* Perform first time calibration */
   bool                      calibrate;
+  /**
+   * @brief   ADC CFG2 register initialization data.
+   * @note    Set before calibration, so calibration runs with the same
+   *          sample time as the conversions that follow.
+   */
+  uint32_t                  cfg2;
 } ADCConfig;
 
 /**
@@ -326,12 +355,53 @@ struct ADCDriver {
    * @brief Current channel index into group channel_mask.
    */
   size_t                    current_channel;
+#if KINETIS_ADC_USE_CONTINUOUS || defined(__DOXYGEN__)
+  /**
+   * @brief The running group is served by the continuous conversion path.
+   */
+  bool                      continuous;
+#endif
+  /**
+   * @brief Calibration is in progress, a started group waits for it.
+   */
+  bool                      calibrating;
+  /**
+   * @brief The cached calibration results below are valid.
+   */
+  bool                      calibrated;
+  /**
+   * @brief Cached OFS register from the last good calibration.
+   */
+  uint16_t                  cal_ofs;
+  /**
+   * @brief Cached PG register from the last good calibration.
+   */
+  uint16_t                  cal_pg;
+  /**
+   * @brief Cached MG register from the last good calibration.
+   */
+  uint16_t                  cal_mg;
 };
 
 /*===========================================================================*/
 /* Driver macros.                                                            */
 /*===========================================================================*/
 
+/**
+ * @brief   Calibration has finished, successfully or not.
+ *
+ * @param[in] adcp      pointer to the @p ADCDriver object
+ */
+#define adc_lld_is_calibrated(adcp) (!(adcp)->calibrating)
+
+/**
+ * @brief   @p sopt7 value pacing conversions from a hardware trigger.
+ *
+ * @param[in] src       a @p SIM_SOPT7_ADC0TRGSEL_xxx trigger source
+ */
+#define ADC_SOPT7_TRIGGER(src)                                              \
+  (SIM_SOPT7_ADC0ALTTRGEN | SIM_SOPT7_ADC0TRGSEL(src))
+
 
 /*===========================================================================*/
 /* External declarations.                                                    */
@@ -43,16 +43,27 @@ BaseChannel CD1;
 /* Driver local functions.                                                   */
 /*===========================================================================*/
 
-static size_t write(void *ip, const uint8_t *bp, size_t n) {
+/*
+ * The host stdio is not reentrant, the kernel is locked while writing so
+ * that a preempting host port cannot switch thread in the middle of it.
+ */
+static size_t con_write(const uint8_t *bp, size_t n) {
   size_t ret;
 
-  (void)ip;
-
+  osalSysLock();
   ret = fwrite(bp, 1, n, stdout);
   fflush(stdout);
+  osalSysUnlock();
   return ret;
 }
 
+static size_t write(void *ip, const uint8_t *bp, size_t n) {
+
+  (void)ip;
+
+  return con_write(bp, n);
+}
+
 static size_t read(void *ip, uint8_t *bp, size_t n) {
 
   (void)ip;
@@ -64,8 +75,7 @@ static msg_t put(void *ip, uint8_t b) {
 
   (void)ip;
 
-  fputc(b, stdout);
-  fflush(stdout);
+  (void)con_write(&b, 1);
   return MSG_OK;
 }
 
@@ -81,8 +91,7 @@ static msg_t putt(void *ip, uint8_t b, systime_t time) {
   (void)ip;
   (void)time;
 
-  fputc(b, stdout);
-  fflush(stdout);
+  (void)con_write(&b, 1);
   return MSG_OK;
 }
 
@@ -95,14 +104,11 @@ static msg_t gett(void *ip, systime_t time) {
 }
 
 static size_t writet(void *ip, const uint8_t *bp, size_t n, systime_t time) {
-  size_t ret;
 
   (void)ip;
   (void)time;
 
-  ret = fwrite(bp, 1, n, stdout);
-  fflush(stdout);
-  return ret;
+  return con_write(bp, n);
 }
 
 static size_t readt(void *ip, uint8_t *bp, size_t n, systime_t time) {
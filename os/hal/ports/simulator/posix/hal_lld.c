@@ -0,0 +1,143 @@
+/*
+    ChibiOS - Copyright (C) 2006..2015 Giovanni Di Sirio
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+        http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+/**
+ * @file    hal_lld.c
+ * @brief   POSIX simulator HAL subsystem low level driver code.
+ *
+ * @addtogroup POSIX_HAL
+ * @{
+ */
+
+#include <signal.h>
+#include <string.h>
+#include <sys/time.h>
+#include <time.h>
+
+#include "hal.h"
+
+/*===========================================================================*/
+/* Driver exported variables.                                                */
+/*===========================================================================*/
+
+/*===========================================================================*/
+/* Driver local variables and types.                                         */
+/*===========================================================================*/
+
+static uint64_t nextcnt;
+static uint64_t slice;
+
+/*===========================================================================*/
+/* Driver local functions.                                                   */
+/*===========================================================================*/
+
+/**
+ * @brief   Host monotonic time in nanoseconds.
+ */
+static uint64_t get_ns(void) {
+  struct timespec ts;
+
+  (void)clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+/**
+ * @brief   Reschedules on exit from a simulated interrupt.
+ */
+static void sim_isr_exit(void) {
+
+  port_lock();
+  _dbg_check_lock();
+  if (chSchIsPreemptionRequired())
+    chSchDoReschedule();
+  _dbg_check_unlock();
+  port_unlock_from_isr();
+}
+
+/*===========================================================================*/
+/* Driver interrupt handlers.                                                */
+/*===========================================================================*/
+
+/*===========================================================================*/
+/* Driver exported functions.                                                */
+/*===========================================================================*/
+
+/**
+ * @brief Low level HAL driver initialization.
+ * @details The system tick is simulated by a periodic @p SIGALRM, the
+ *          signal handler is provided by the RT port.
+ */
+void hal_lld_init(void) {
+  struct sigaction sa;
+  struct itimerval itv;
+
+  printf("ChibiOS/RT simulator (POSIX)\n");
+
+  slice = 1000000000ULL / CH_CFG_ST_FREQUENCY;
+  nextcnt = get_ns() + slice;
+
+  memset(&sa, 0, sizeof(sa));
+  sa.sa_handler = _port_signal_handler;
+  sigemptyset(&sa.sa_mask);
+  sa.sa_flags = SA_RESTART;
+  if (sigaction(SIGALRM, &sa, NULL) != 0) {
+    printf("sigaction() error\n");
+    exit(1);
+  }
+
+  itv.it_interval.tv_sec = 0;
+  itv.it_interval.tv_usec = 1000000 / CH_CFG_ST_FREQUENCY;
+  itv.it_value = itv.it_interval;
+  if (setitimer(ITIMER_REAL, &itv, NULL) != 0) {
+    printf("setitimer() error\n");
+    exit(1);
+  }
+
+  fflush(stdout);
+}
+
+/**
+ * @brief   Interrupt simulation.
+ * @details Ticks the host delivered late or merged are recovered by
+ *          comparing with the host monotonic clock, one at time and with
+ *          a reschedule after each one so that the threads they wake up
+ *          run before the next tick is processed.
+ */
+void _sim_check_for_interrupts(void) {
+
+#if HAL_USE_SERIAL
+  if (sd_lld_interrupt_pending()) {
+    sim_isr_exit();
+  }
+#endif
+
+  /* Interrupt Timer simulation.*/
+  while (get_ns() >= nextcnt) {
+    nextcnt += slice;
+
+    CH_IRQ_PROLOGUE();
+
+    chSysLockFromISR();
+    chSysTimerHandlerI();
+    chSysUnlockFromISR();
+
+    CH_IRQ_EPILOGUE();
+
+    sim_isr_exit();
+  }
+}
+
+/** @} */
@@ -38,6 +38,36 @@
 /* Module pre-compile time settings.                                         */
 /*===========================================================================*/
 
+/**
+ * @brief   Two levels segregated fit heap allocator.
+ * @details If enabled then the free blocks are kept in size segregated
+ *          lists indexed by two levels of bitmaps (TLSF) instead of a
+ *          single address ordered list, allocation and release are constant
+ *          time operations and adjacent free blocks are merged immediately.
+ * @note    The default is @p FALSE.
+ */
+#if !defined(CH_CFG_HEAP_TLSF) || defined(__DOXYGEN__)
+#define CH_CFG_HEAP_TLSF                    FALSE
+#endif
+
+/**
+ * @brief   TLSF second level bits.
+ * @details Each power of two size range is split in 2^N lists.
+ * @note    The default is 3.
+ */
+#if !defined(CH_CFG_HEAP_TLSF_SL_BITS) || defined(__DOXYGEN__)
+#define CH_CFG_HEAP_TLSF_SL_BITS            3
+#endif
+
+/**
+ * @brief   TLSF largest size class.
+ * @details Blocks of 2^N bytes or bigger all share the last list.
+ * @note    The default is 20.
+ */
+#if !defined(CH_CFG_HEAP_TLSF_FL_MAX) || defined(__DOXYGEN__)
+#define CH_CFG_HEAP_TLSF_FL_MAX             20
+#endif
+
 /*===========================================================================*/
 /* Derived constants and error checks.                                       */
 /*===========================================================================*/
@@ -50,6 +80,43 @@
 #error "CH_CFG_USE_HEAP requires CH_CFG_USE_MUTEXES and/or CH_CFG_USE_SEMAPHORES"
 #endif
 
+#if (CH_CFG_HEAP_TLSF == TRUE) || defined(__DOXYGEN__)
+#if (CH_CFG_HEAP_TLSF_SL_BITS < 1) || (CH_CFG_HEAP_TLSF_SL_BITS > 5)
+#error "invalid CH_CFG_HEAP_TLSF_SL_BITS specified, must be 1...5"
+#endif
+
+#if (CH_CFG_HEAP_TLSF_FL_MAX < 10) || (CH_CFG_HEAP_TLSF_FL_MAX > 31)
+#error "invalid CH_CFG_HEAP_TLSF_FL_MAX specified, must be 10...31"
+#endif
+
+/**
+ * @brief   Number of second level lists for each first level class.
+ */
+#define CH_HEAP_TLSF_SL_COUNT   (1U << CH_CFG_HEAP_TLSF_SL_BITS)
+
+/**
+ * @brief   Base two logarithm of the memory alignment.
+ * @note    The TLSF allocator requires an alignment of at least 4 bytes, the
+ *          two lower bits of the block size are used as flags.
+ */
+#define CH_HEAP_TLSF_ALIGN_LOG2                                             \
+  ((MEM_ALIGN_SIZE >= 16U) ? 4U : ((MEM_ALIGN_SIZE >= 8U) ? 3U : 2U))
+
+/**
+ * @brief   Base two logarithm of the smallest first level class size.
+ * @details Smaller blocks are all in the first class, one list for each
+ *          aligned size.
+ */
+#define CH_HEAP_TLSF_FL_SHIFT                                               \
+  ((unsigned)CH_CFG_HEAP_TLSF_SL_BITS + CH_HEAP_TLSF_ALIGN_LOG2)
+
+/**
+ * @brief   Number of first level classes.
+ */
+#define CH_HEAP_TLSF_FL_COUNT                                               \
+  ((unsigned)CH_CFG_HEAP_TLSF_FL_MAX - CH_HEAP_TLSF_FL_SHIFT + 2U)
+#endif
+
 /*===========================================================================*/
 /* Module data structures and types.                                         */
 /*===========================================================================*/
@@ -70,6 +137,11 @@ union heap_header {
       memory_heap_t     *heap;      /**< @brief Block owner heap.           */
     } u;                            /**< @brief Overlapped fields.          */
     size_t              size;       /**< @brief Size of the memory block.   */
+#if (CH_CFG_HEAP_TLSF == TRUE) || defined(__DOXYGEN__)
+    union heap_header   *prev;      /**< @brief Previous block in free list.*/
+    union heap_header   *phys;      /**< @brief Previous block in memory or
+                                                @p NULL if first.           */
+#endif
   } h;
 };
 
@@ -79,7 +151,17 @@ union heap_header {
 struct memory_heap {
   memgetfunc_t          h_provider; /**< @brief Memory blocks provider for
                                                 this heap.                  */
+#if (CH_CFG_HEAP_TLSF == TRUE) || defined(__DOXYGEN__)
+  uint32_t              h_flmap;    /**< @brief Non-empty first level
+                                                classes.                    */
+  uint32_t              h_slmap[CH_HEAP_TLSF_FL_COUNT];
+                                    /**< @brief Non-empty second level
+                                                lists of each class.        */
+  union heap_header     *h_lists[CH_HEAP_TLSF_FL_COUNT][CH_HEAP_TLSF_SL_COUNT];
+                                    /**< @brief Free blocks lists.          */
+#else
   union heap_header     h_free;     /**< @brief Free blocks list header.    */
+#endif
 #if CH_CFG_USE_MUTEXES == TRUE
   mutex_t               h_mtx;      /**< @brief Heap access mutex.          */
 #else
@@ -102,7 +184,7 @@ extern "C" {
   void chHeapObjectInit(memory_heap_t *heapp, void *buf, size_t size);
   void *chHeapAlloc(memory_heap_t *heapp, size_t size);
   void chHeapFree(void *p);
-  size_t chHeapStatus(memory_heap_t *heapp, size_t *sizep);
+  size_t chHeapStatus(memory_heap_t *heapp, size_t *totalp, size_t *largestp);
 #ifdef __cplusplus
 }
 #endif
@@ -38,6 +38,17 @@
 /* Module pre-compile time settings.                                         */
 /*===========================================================================*/
 
+/**
+ * @brief   Memory pool magazines.
+ * @details If enabled then the per-thread magazine APIs are included, a
+ *          magazine caches objects of a memory pool and exchanges them
+ *          with the pool in batches.
+ * @note    The default is @p FALSE.
+ */
+#if !defined(CH_CFG_USE_POOL_MAGAZINES) || defined(__DOXYGEN__)
+#define CH_CFG_USE_POOL_MAGAZINES           FALSE
+#endif
+
 /*===========================================================================*/
 /* Derived constants and error checks.                                       */
 /*===========================================================================*/
@@ -69,6 +80,39 @@ typedef struct {
                                                     for this pool.          */
 } memory_pool_t;
 
+#if (CH_CFG_USE_POOL_MAGAZINES == TRUE) || defined(__DOXYGEN__)
+/**
+ * @brief   Memory pool magazine statistics.
+ */
+typedef struct {
+  ucnt_t                pms_hits;       /**< @brief Allocations served by
+                                                    the magazine.           */
+  ucnt_t                pms_misses;     /**< @brief Allocations that found
+                                                    the magazine empty.     */
+  ucnt_t                pms_refills;    /**< @brief Batches fetched from
+                                                    the pool.               */
+  ucnt_t                pms_drains;     /**< @brief Batches returned to
+                                                    the pool.               */
+} pool_magazine_stats_t;
+
+/**
+ * @brief   Memory pool magazine descriptor.
+ * @details A magazine caches objects of a memory pool on behalf of a single
+ *          thread, the objects are moved between the magazine and the pool
+ *          in batches so most allocations and releases do not enter the
+ *          kernel critical zone.
+ */
+typedef struct {
+  memory_pool_t         *pm_pool;       /**< @brief Associated pool.        */
+  struct pool_header    *pm_next;       /**< @brief Cached objects list.    */
+  size_t                pm_cnt;         /**< @brief Cached objects count.   */
+  size_t                pm_size;        /**< @brief Magazine capacity.      */
+  size_t                pm_batch;       /**< @brief Objects exchanged with
+                                                    the pool at once.       */
+  pool_magazine_stats_t pm_stats;       /**< @brief Magazine statistics.    */
+} pool_magazine_t;
+#endif
+
 /*===========================================================================*/
 /* Module macros.                                                            */
 /*===========================================================================*/
@@ -111,6 +155,13 @@ extern "C" {
   void *chPoolAlloc(memory_pool_t *mp);
   void chPoolFreeI(memory_pool_t *mp, void *objp);
   void chPoolFree(memory_pool_t *mp, void *objp);
+#if CH_CFG_USE_POOL_MAGAZINES == TRUE
+  void chPoolMagazineObjectInit(pool_magazine_t *pmp, memory_pool_t *mp,
+                                size_t size, size_t batch);
+  void *chPoolMagazineAlloc(pool_magazine_t *pmp);
+  void chPoolMagazineFree(pool_magazine_t *pmp, void *objp);
+  void chPoolMagazineFlush(pool_magazine_t *pmp);
+#endif
 #ifdef __cplusplus
 }
 #endif
@@ -161,6 +212,22 @@ static inline void chPoolAddI(memory_pool_t *mp, void *objp) {
   chPoolFreeI(mp, objp);
 }
 
+#if (CH_CFG_USE_POOL_MAGAZINES == TRUE) || defined(__DOXYGEN__)
+/**
+ * @brief   Returns the statistics of a magazine.
+ *
+ * @param[in] pmp       pointer to a @p pool_magazine_t structure
+ * @return              Pointer to the magazine statistics.
+ *
+ * @xclass
+ */
+static inline const pool_magazine_stats_t *
+chPoolMagazineGetStatsX(pool_magazine_t *pmp) {
+
+  return &pmp->pm_stats;
+}
+#endif /* CH_CFG_USE_POOL_MAGAZINES == TRUE */
+
 #endif /* CH_CFG_USE_MEMPOOLS == TRUE */
 
 #endif /* _CHMEMPOOLS_H_ */
@@ -162,10 +162,71 @@
 /* Module pre-compile time settings.                                         */
 /*===========================================================================*/
 
+/**
+ * @brief   Bitmap indexed ready list.
+ * @details If enabled then the ready list keeps a bitmap of the ready
+ *          priorities and a pointer to the last ready thread of each
+ *          priority, this makes the insertion in the ready list a constant
+ *          time operation regardless of the number of ready threads.
+ * @note    The default is @p FALSE.
+ * @note    Requires (ABSPRIO + 1) pointers of extra RAM.
+ */
+#if !defined(CH_CFG_SCHED_BITMAP) || defined(__DOXYGEN__)
+#define CH_CFG_SCHED_BITMAP                 FALSE
+#endif
+
+/**
+ * @brief   Hierarchical timing wheel for virtual timers.
+ * @details If enabled then the virtual timers are kept in a hierarchical
+ *          timing wheel instead of a delta list, setting and resetting a
+ *          timer are constant time operations regardless of the number of
+ *          armed timers.
+ * @note    The default is @p FALSE.
+ */
+#if !defined(CH_CFG_VT_WHEEL) || defined(__DOXYGEN__)
+#define CH_CFG_VT_WHEEL                     FALSE
+#endif
+
+/**
+ * @brief   Timing wheel bits per level.
+ * @details Each level of the wheel has 2^N slots, the number of levels
+ *          is enough to cover the whole @p systime_t range.
+ * @note    The default is 4, 16 slots per level.
+ */
+#if !defined(CH_CFG_VT_WHEEL_BITS) || defined(__DOXYGEN__)
+#define CH_CFG_VT_WHEEL_BITS                4
+#endif
+
 /*===========================================================================*/
 /* Derived constants and error checks.                                       */
 /*===========================================================================*/
 
+#if (CH_CFG_SCHED_BITMAP == TRUE) || defined(__DOXYGEN__)
+/**
+ * @brief   Number of 32 bits words in the ready priorities bitmap.
+ * @note    One bit for each priority level up to @p ABSPRIO.
+ */
+#define CH_SCHED_BITMAP_WORDS   8U
+#endif
+
+#if (CH_CFG_VT_WHEEL == TRUE) || defined(__DOXYGEN__)
+#if (CH_CFG_VT_WHEEL_BITS < 1) || (CH_CFG_VT_WHEEL_BITS > 5)
+#error "invalid CH_CFG_VT_WHEEL_BITS specified, must be 1...5"
+#endif
+
+/**
+ * @brief   Number of slots in each level of the timing wheel.
+ */
+#define CH_VT_WHEEL_SLOTS       (1U << CH_CFG_VT_WHEEL_BITS)
+
+/**
+ * @brief   Number of levels of the timing wheel.
+ */
+#define CH_VT_WHEEL_LEVELS      ((CH_CFG_ST_RESOLUTION +                    \
+                                  CH_CFG_VT_WHEEL_BITS - 1) /               \
+                                 CH_CFG_VT_WHEEL_BITS)
+#endif
+
 /*===========================================================================*/
 /* Module data structures and types.                                         */
 /*===========================================================================*/
@@ -370,6 +431,16 @@ struct ch_virtual_timer {
                                                 parameter.                  */
 };
 
+/**
+ * @brief   Timing wheel slot header.
+ * @note    Shares the link fields with @p virtual_timer_t, the slot is the
+ *          header of a circular list of timers.
+ */
+struct ch_virtual_timers_slot {
+  virtual_timer_t       *vt_next;   /**< @brief First timer in the slot.    */
+  virtual_timer_t       *vt_prev;   /**< @brief Last timer in the slot.     */
+};
+
 /**
  * @brief   Virtual timers list header.
  * @note    The timers list is implemented as a double link bidirectional list
@@ -392,6 +463,13 @@ struct ch_virtual_timers_list {
   systime_t             vt_lasttime;/**< @brief System time of the last
                                                 tick event.                 */
 #endif
+#if (CH_CFG_VT_WHEEL == TRUE) || defined(__DOXYGEN__)
+  uint32_t              vt_map[CH_VT_WHEEL_LEVELS];
+                                    /**< @brief Non-empty slots of each
+                                                level.                      */
+  virtual_timers_slot_t vt_wheel[CH_VT_WHEEL_LEVELS][CH_VT_WHEEL_SLOTS];
+                                    /**< @brief Timing wheel slots.         */
+#endif
 };
 
 /**
@@ -410,6 +488,15 @@ struct ch_ready_list {
   /* End of the fields shared with the thread_t structure.*/
   thread_t              *r_current; /**< @brief The currently running
                                                 thread.                     */
+#if (CH_CFG_SCHED_BITMAP == TRUE) || defined(__DOXYGEN__)
+  uint32_t              r_mapgrp;   /**< @brief Non-empty words of
+                                                @p r_map.                   */
+  uint32_t              r_map[CH_SCHED_BITMAP_WORDS];
+                                    /**< @brief Ready priorities bitmap.    */
+  thread_t              *r_tail[(unsigned)ABSPRIO + 1U];
+                                    /**< @brief Last ready thread of each
+                                                priority.                   */
+#endif
 };
 
 /**
@@ -528,6 +615,7 @@ extern ch_system_t ch;
 extern "C" {
 #endif
   void _scheduler_init(void);
+  thread_t *_scheduler_dequeue(thread_t *tp, tprio_t prio);
   thread_t *chSchReadyI(thread_t *tp);
   void chSchGoSleepS(tstate_t newstate);
   msg_t chSchGoSleepTimeoutS(tstate_t newstate, systime_t time);
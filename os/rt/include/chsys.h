@@ -271,6 +271,12 @@
 /* External declarations.                                                    */
 /*===========================================================================*/
 
+#if !defined(port_clz) || !defined(port_ctz)
+#if !defined(__DOXYGEN__)
+extern const uint8_t ch_bit_index[32];
+#endif
+#endif
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -292,6 +298,65 @@ extern "C" {
 /* Module inline functions.                                                  */
 /*===========================================================================*/
 
+#if !defined(port_clz) || !defined(port_ctz) || defined(__DOXYGEN__)
+/**
+ * @brief   Position of the only bit set in a word.
+ * @details De Bruijn multiply and table lookup, for ports without a bit
+ *          scan instruction.
+ *
+ * @param[in] b         the word, exactly one bit must be set
+ * @return              The bit position.
+ *
+ * @notapi
+ */
+static inline unsigned ch_bit_position(uint32_t b) {
+
+  return (unsigned)ch_bit_index[(uint32_t)(b * 0x077CB531U) >> 27];
+}
+#endif
+
+/**
+ * @brief   Number of leading zero bits in a word.
+ * @details The port's @p port_clz() when it has one.
+ *
+ * @param[in] x         the word, must not be zero
+ * @return              The number of zero bits above the highest one.
+ *
+ * @notapi
+ */
+static inline unsigned ch_clz(uint32_t x) {
+
+#if defined(port_clz)
+  return port_clz(x);
+#else
+  /* Smearing the highest bit downward leaves it isolated in x ^ (x >> 1).*/
+  x |= x >> 1;
+  x |= x >> 2;
+  x |= x >> 4;
+  x |= x >> 8;
+  x |= x >> 16;
+  return 31U - ch_bit_position(x ^ (x >> 1));
+#endif
+}
+
+/**
+ * @brief   Number of trailing zero bits in a word.
+ * @details The port's @p port_ctz() when it has one.
+ *
+ * @param[in] x         the word, must not be zero
+ * @return              The number of zero bits below the lowest one.
+ *
+ * @notapi
+ */
+static inline unsigned ch_ctz(uint32_t x) {
+
+#if defined(port_ctz)
+  return port_ctz(x);
+#else
+  return ch_bit_position(x & (0U - x));
+#endif
+}
+
 /**
  * @brief   Raises the system interrupt priority mask to the maximum level.
  * @details All the maskable interrupt sources are disabled regardless their
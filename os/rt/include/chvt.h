@@ -188,6 +188,10 @@ extern "C" {
   void chVTDoSetI(virtual_timer_t *vtp, systime_t delay,
                   vtfunc_t vtfunc, void *par);
   void chVTDoResetI(virtual_timer_t *vtp);
+#if CH_CFG_VT_WHEEL == TRUE
+  bool chVTGetTimersStateI(systime_t *timep);
+  void chVTDoTickI(void);
+#endif
 #ifdef __cplusplus
 }
 #endif
@@ -324,6 +328,7 @@ static inline bool chVTIsSystemTimeWithin(systime_t start, systime_t end) {
   return chVTIsTimeWithinX(chVTGetSystemTime(), start, end);
 }
 
+#if (CH_CFG_VT_WHEEL == FALSE) || defined(__DOXYGEN__)
 /**
  * @brief   Returns the time interval until the next timer event.
  * @note    The return value is not perfectly accurate and can report values
@@ -359,6 +364,7 @@ static inline bool chVTGetTimersStateI(systime_t *timep) {
 
   return true;
 }
+#endif /* CH_CFG_VT_WHEEL == FALSE */
 
 /**
  * @brief   Returns @p true if the specified timer is armed.
@@ -490,6 +496,7 @@ static inline void chVTSet(virtual_timer_t *vtp, systime_t delay,
   chSysUnlock();
 }
 
+#if (CH_CFG_VT_WHEEL == FALSE) || defined(__DOXYGEN__)
 /**
  * @brief   Virtual timers ticker.
  * @note    The system lock is released before entering the callback and
@@ -585,6 +592,7 @@ static inline void chVTDoTickI(void) {
               "exceeding delta");
 #endif /* CH_CFG_ST_TIMEDELTA > 0 */
 }
+#endif /* CH_CFG_VT_WHEEL == FALSE */
 
 #endif /* _CHVT_H_ */
 
@@ -335,6 +335,18 @@ struct port_intctx {
  */
 #define PORT_FAST_IRQ_HANDLER(id) void id(void)
 
+/**
+ * @brief   Count of leading zeros, the CLZ instruction.
+ * @note    Undefined for zero.
+ */
+#define port_clz(x) ((unsigned)__CLZ((uint32_t)(x)))
+
+/**
+ * @brief   Count of trailing zeros, RBIT then CLZ.
+ * @note    Undefined for zero.
+ */
+#define port_ctz(x) ((unsigned)__CLZ(__RBIT((uint32_t)(x))))
+
 /**
  * @brief   Performs a context switch between two threads.
  * @details This is the most critical code in any port, this function
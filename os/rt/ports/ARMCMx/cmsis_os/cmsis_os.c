@@ -149,9 +149,13 @@ osStatus osThreadTerminate(osThreadId thread_id) {
 osStatus osThreadSetPriority(osThreadId thread_id, osPriority newprio) {
   osPriority oldprio;
   thread_t * tp = (thread_t *)thread_id;
+  tprio_t readyprio;
 
   chSysLock();
 
+  /* Priority the thread is queued with, if ready.*/
+  readyprio = tp->p_prio;
+
   /* Changing priority.*/
 #if CH_CFG_USE_MUTEXES
   oldprio = (osPriority)tp->p_realprio;
@@ -192,7 +196,7 @@ osStatus osThreadSetPriority(osThreadId thread_id, osPriority newprio) {
     tp->p_state = CH_STATE_CURRENT;
 #endif
     /* Re-enqueues tp with its new priority on the ready list.*/
-    chSchReadyI(queue_dequeue(tp));
+    chSchReadyI(_scheduler_dequeue(tp, readyprio));
     break;
   }
 
@@ -232,6 +232,18 @@ struct context {
  */
 #define PORT_FAST_IRQ_HANDLER(id) void id(void)
 
+/**
+ * @brief   Count of leading zeros, the host bit scan instruction.
+ * @note    Undefined for zero.
+ */
+#define port_clz(x) ((unsigned)__builtin_clz((uint32_t)(x)))
+
+/**
+ * @brief   Count of trailing zeros, the host bit scan instruction.
+ * @note    Undefined for zero.
+ */
+#define port_ctz(x) ((unsigned)__builtin_ctz((uint32_t)(x)))
+
 /*===========================================================================*/
 /* External declarations.                                                    */
 /*===========================================================================*/
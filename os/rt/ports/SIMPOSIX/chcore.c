@@ -0,0 +1,149 @@
+/*
+    ChibiOS - Copyright (C) 2006..2015 Giovanni Di Sirio.
+
+    This file is part of ChibiOS.
+
+    ChibiOS is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    ChibiOS is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/**
+ * @file    SIMPOSIX/chcore.c
+ * @brief   Simulator on POSIX port code.
+ *
+ * @addtogroup SIMPOSIX_GCC_CORE
+ * @{
+ */
+
+#include <time.h>
+
+#include "ch.h"
+
+/*===========================================================================*/
+/* Module local definitions.                                                 */
+/*===========================================================================*/
+
+/*===========================================================================*/
+/* Module exported variables.                                                */
+/*===========================================================================*/
+
+bool port_isr_context_flag;
+volatile syssts_t port_irq_sts = (syssts_t)1;
+volatile sig_atomic_t port_irq_pending;
+
+/*===========================================================================*/
+/* Module local types.                                                       */
+/*===========================================================================*/
+
+/*===========================================================================*/
+/* Module local variables.                                                   */
+/*===========================================================================*/
+
+/*===========================================================================*/
+/* Module local functions.                                                   */
+/*===========================================================================*/
+
+/**
+ * @brief   Serves the simulated interrupts until none is pending.
+ * @note    Must be invoked with the host signal blocked and the simulated
+ *          interrupts enabled.
+ */
+static void serve_interrupts(void) {
+
+  while (port_irq_pending != 0) {
+    port_irq_pending = 0;
+    _sim_check_for_interrupts();
+  }
+}
+
+/*===========================================================================*/
+/* Module exported functions.                                                */
+/*===========================================================================*/
+
+/**
+ * @brief   Performs a context switch between two threads.
+ * @details The host context, signal mask included, is saved into the
+ *          outgoing thread and restored from the incoming one.
+ *
+ * @param[in] ntp       the thread to be switched in
+ * @param[in] otp       the thread to be switched out
+ */
+void port_switch(thread_t *ntp, thread_t *otp) {
+
+  (void)swapcontext(&otp->p_ctx.ctx.uc, &ntp->p_ctx.ctx.uc);
+}
+
+/**
+ * @brief   Start a thread by invoking its work function.
+ * @details If the work function returns @p chThdExit() is automatically
+ *          invoked.
+ */
+void _port_thread_start(void) {
+
+  chSysUnlock();
+  currp->p_ctx.pf(currp->p_ctx.arg);
+  chThdExit(0);
+  while(1);
+}
+
+/**
+ * @brief   Serves the interrupts that arrived while the kernel was locked.
+ * @details The host signal is blocked while serving so that the simulated
+ *          interrupts do not nest.
+ */
+void _port_serve_pending(void) {
+  sigset_t set, oset;
+
+  (void)sigemptyset(&set);
+  (void)sigaddset(&set, SIGALRM);
+  (void)sigprocmask(SIG_BLOCK, &set, &oset);
+  serve_interrupts();
+  (void)sigprocmask(SIG_SETMASK, &oset, NULL);
+}
+
+/**
+ * @brief   Host signal handler.
+ * @details Simulated interrupts are served immediately unless masked, in
+ *          that case they are left pending until the next kernel unlock.
+ *          The host blocks the signal while its handler is running.
+ * @note    Interrupts are also masked while an interrupt handler runs in
+ *          thread context, the simulator code can invoke
+ *          @p _sim_check_for_interrupts() directly.
+ *
+ * @param[in] sig       the signal number
+ */
+void _port_signal_handler(int sig) {
+
+  (void)sig;
+
+  port_irq_pending = 1;
+  if ((port_irq_sts == (syssts_t)0) && !port_isr_context_flag) {
+    serve_interrupts();
+  }
+}
+
+/**
+ * @brief   Returns the current value of the realtime counter.
+ *
+ * @return              The realtime counter value, in nanoseconds.
+ */
+rtcnt_t port_rt_get_counter_value(void) {
+  struct timespec ts;
+
+  (void)clock_gettime(CLOCK_MONOTONIC, &ts);
+
+  return (rtcnt_t)((uint64_t)ts.tv_sec * 1000000000ULL +
+                   (uint64_t)ts.tv_nsec);
+}
+
+/** @} */
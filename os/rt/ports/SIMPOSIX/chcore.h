@@ -0,0 +1,379 @@
+/*
+    ChibiOS - Copyright (C) 2006..2015 Giovanni Di Sirio.
+
+    This file is part of ChibiOS.
+
+    ChibiOS is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    ChibiOS is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/**
+ * @file    SIMPOSIX/chcore.h
+ * @brief   Simulator on POSIX port macros and structures.
+ *
+ * @addtogroup SIMPOSIX_GCC_CORE
+ * @{
+ */
+
+#ifndef _CHCORE_H_
+#define _CHCORE_H_
+
+#include <signal.h>
+#include <ucontext.h>
+
+/*===========================================================================*/
+/* Module constants.                                                         */
+/*===========================================================================*/
+
+/**
+ * Macro defining a simulated architecture on a POSIX host.
+ */
+#define PORT_ARCHITECTURE_SIMPOSIX
+
+/**
+ * Name of the implemented architecture.
+ */
+#define PORT_ARCHITECTURE_NAME          "Simulator"
+
+/**
+ * @brief   Name of the architecture variant (optional).
+ */
+#define PORT_CORE_VARIANT_NAME          "POSIX (ucontext)"
+
+/**
+ * @brief   Name of the compiler supported by this port.
+ */
+#define PORT_COMPILER_NAME              "GCC " __VERSION__
+
+/**
+ * @brief   Port-specific information string.
+ */
+#define PORT_INFO                       "Preemption on SIGALRM"
+
+/**
+ * @brief   This port supports a realtime counter.
+ */
+#define PORT_SUPPORTS_RT                TRUE
+
+/*===========================================================================*/
+/* Module pre-compile time settings.                                         */
+/*===========================================================================*/
+
+/**
+ * @brief   Stack size for the system idle thread.
+ * @details This size depends on the idle thread implementation, usually
+ *          the idle thread should take no more space than those reserved
+ *          by @p PORT_INT_REQUIRED_STACK.
+ */
+#ifndef PORT_IDLE_THREAD_STACK_SIZE
+#define PORT_IDLE_THREAD_STACK_SIZE     256
+#endif
+
+/**
+ * @brief   Per-thread stack overhead for interrupts servicing.
+ * @details This constant is used in the calculation of the correct working
+ *          area size. Simulated interrupts are signal handlers running on
+ *          the current thread stack, the host signal frame is included.
+ */
+#ifndef PORT_INT_REQUIRED_STACK
+#define PORT_INT_REQUIRED_STACK         32768
+#endif
+
+/**
+ * @brief   Enables an alternative timer implementation.
+ * @details Usually the port uses a timer interface defined in the file
+ *          @p chcore_timer.h, if this option is enabled then the file
+ *          @p chcore_timer_alt.h is included instead.
+ */
+#if !defined(PORT_USE_ALT_TIMER)
+#define PORT_USE_ALT_TIMER              FALSE
+#endif
+
+/*===========================================================================*/
+/* Derived constants and error checks.                                       */
+/*===========================================================================*/
+
+#if CH_DBG_ENABLE_STACK_CHECK
+#error "option CH_DBG_ENABLE_STACK_CHECK not supported by this port"
+#endif
+
+#if CH_CFG_ST_TIMEDELTA > 0
+#error "this port does not support tick-less mode"
+#endif
+
+/*===========================================================================*/
+/* Module data structures and types.                                         */
+/*===========================================================================*/
+
+/**
+ * @brief   16 bytes stack and memory alignment enforcement.
+ */
+typedef struct {
+  uint8_t a[16];
+} stkalign_t __attribute__((aligned(16)));
+
+/**
+ * @brief   Interrupt saved context.
+ * @details The host saves it in the signal frame, nothing in this port.
+ */
+struct port_extctx {
+};
+
+/**
+ * @brief   System saved context.
+ * @details The host context, registers and signal mask.
+ */
+struct port_intctx {
+  ucontext_t              uc;
+};
+
+/**
+ * @brief   Platform dependent part of the @p thread_t structure.
+ * @details The saved context is kept in the thread structure itself, the
+ *          thread function and its argument are picked up from here when
+ *          the thread runs for the first time.
+ */
+struct context {
+  struct port_intctx      ctx;
+  void                    (*pf)(void *p);
+  void                    *arg;
+};
+
+/*===========================================================================*/
+/* Module macros.                                                            */
+/*===========================================================================*/
+
+/**
+ * @brief   Platform dependent part of the @p chThdCreateI() API.
+ * @details The thread stack is the working area above the @p thread_t
+ *          structure.
+ */
+#define PORT_SETUP_CONTEXT(tp, workspace, wsize, pf, arg) {                 \
+  (void)getcontext(&(tp)->p_ctx.ctx.uc);                                    \
+  (tp)->p_ctx.ctx.uc.uc_stack.ss_sp = (void *)((tp) + 1);                   \
+  (tp)->p_ctx.ctx.uc.uc_stack.ss_size = (size_t)(wsize) - sizeof (thread_t);\
+  (tp)->p_ctx.ctx.uc.uc_link = NULL;                                        \
+  (tp)->p_ctx.pf = (pf);                                                    \
+  (tp)->p_ctx.arg = (arg);                                                  \
+  makecontext(&(tp)->p_ctx.ctx.uc, _port_thread_start, 0);                  \
+}
+
+/**
+ * @brief   Computes the thread working area global size.
+ * @note    There is no need to perform alignments in this macro.
+ */
+#define PORT_WA_SIZE(n) ((sizeof(void *) * 4U) +                            \
+                         ((size_t)(n)) +                                    \
+                         ((size_t)(PORT_INT_REQUIRED_STACK)))
+
+/**
+ * @brief   IRQ prologue code.
+ * @details This macro must be inserted at the start of all IRQ handlers
+ *          enabled to invoke system APIs.
+ */
+#define PORT_IRQ_PROLOGUE() {                                               \
+  port_isr_context_flag = true;                                             \
+}
+
+/**
+ * @brief   IRQ epilogue code.
+ * @details This macro must be inserted at the end of all IRQ handlers
+ *          enabled to invoke system APIs.
+ */
+#define PORT_IRQ_EPILOGUE() {                                               \
+  port_isr_context_flag = false;                                            \
+}
+
+/**
+ * @brief   IRQ handler function declaration.
+ * @note    @p id can be a function name or a vector number depending on the
+ *          port implementation.
+ */
+#define PORT_IRQ_HANDLER(id) void id(void)
+
+/**
+ * @brief   Fast IRQ handler function declaration.
+ * @note    @p id can be a function name or a vector number depending on the
+ *          port implementation.
+ */
+#define PORT_FAST_IRQ_HANDLER(id) void id(void)
+
+/**
+ * @brief   Count of leading zeros, the host bit scan instruction.
+ * @note    Undefined for zero.
+ */
+#define port_clz(x) ((unsigned)__builtin_clz((uint32_t)(x)))
+
+/**
+ * @brief   Count of trailing zeros, the host bit scan instruction.
+ * @note    Undefined for zero.
+ */
+#define port_ctz(x) ((unsigned)__builtin_ctz((uint32_t)(x)))
+
+/*===========================================================================*/
+/* External declarations.                                                    */
+/*===========================================================================*/
+
+extern bool port_isr_context_flag;
+extern volatile syssts_t port_irq_sts;
+extern volatile sig_atomic_t port_irq_pending;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+  void port_switch(thread_t *ntp, thread_t *otp);
+  void _port_thread_start(void);
+  void _port_serve_pending(void);
+  void _port_signal_handler(int sig);
+  rtcnt_t port_rt_get_counter_value(void);
+  void _sim_check_for_interrupts(void);
+#ifdef __cplusplus
+}
+#endif
+
+/*===========================================================================*/
+/* Module inline functions.                                                  */
+/*===========================================================================*/
+
+/**
+ * @brief   Port-related initialization code.
+ * @note    Simulated interrupts stay disabled until @p chSysInit()
+ *          enables them.
+ */
+static inline void port_init(void) {
+
+  port_irq_sts = (syssts_t)1;
+  port_irq_pending = 0;
+  port_isr_context_flag = false;
+}
+
+/**
+ * @brief   Returns a word encoding the current interrupts status.
+ *
+ * @return              The interrupts status.
+ */
+static inline syssts_t port_get_irq_status(void) {
+
+  return port_irq_sts;
+}
+
+/**
+ * @brief   Checks the interrupt status.
+ *
+ * @param[in] sts       the interrupt status word
+ *
+ * @return              The interrupt status.
+ * @retvel false        the word specified a disabled interrupts status.
+ * @retvel true         the word specified an enabled interrupts status.
+ */
+static inline bool port_irq_enabled(syssts_t sts) {
+
+  return sts == (syssts_t)0;
+}
+
+/**
+ * @brief   Determines the current execution context.
+ *
+ * @return              The execution context.
+ * @retval false        not running in ISR mode.
+ * @retval true         running in ISR mode.
+ */
+static inline bool port_is_isr_context(void) {
+
+  return port_isr_context_flag;
+}
+
+/**
+ * @brief   Kernel-lock action.
+ * @details Signals arriving while locked are not blocked at the host
+ *          level, their handler just marks them pending. This keeps the
+ *          lock free of system calls.
+ */
+static inline void port_lock(void) {
+
+  port_irq_sts = (syssts_t)1;
+  asm volatile ("" : : : "memory");
+}
+
+/**
+ * @brief   Kernel-unlock action.
+ * @details Serves any simulated interrupt that arrived while locked.
+ */
+static inline void port_unlock(void) {
+
+  asm volatile ("" : : : "memory");
+  port_irq_sts = (syssts_t)0;
+  asm volatile ("" : : : "memory");
+  if (port_irq_pending != 0) {
+    _port_serve_pending();
+  }
+}
+
+/**
+ * @brief   Kernel-lock action from an interrupt handler.
+ * @note    Same as @p port_lock() in this port.
+ */
+static inline void port_lock_from_isr(void) {
+
+  port_irq_sts = (syssts_t)1;
+  asm volatile ("" : : : "memory");
+}
+
+/**
+ * @brief   Kernel-unlock action from an interrupt handler.
+ * @note    Pending interrupts are served on the way out of the handler.
+ */
+static inline void port_unlock_from_isr(void) {
+
+  asm volatile ("" : : : "memory");
+  port_irq_sts = (syssts_t)0;
+}
+
+/**
+ * @brief   Disables all the interrupt sources.
+ */
+static inline void port_disable(void) {
+
+  port_lock();
+}
+
+/**
+ * @brief   Disables the interrupt sources below kernel-level priority.
+ */
+static inline void port_suspend(void) {
+
+  port_lock();
+}
+
+/**
+ * @brief   Enables all the interrupt sources.
+ */
+static inline void port_enable(void) {
+
+  port_unlock();
+}
+
+/**
+ * @brief   Enters an architecture-dependent IRQ-waiting mode.
+ * @details The host process sleeps until the next signal.
+ */
+static inline void port_wait_for_interrupt(void) {
+  sigset_t set;
+
+  (void)sigemptyset(&set);
+  (void)sigsuspend(&set);
+}
+
+#endif /* _CHCORE_H_ */
+
+/** @} */
@@ -0,0 +1,7 @@
+# List of the ChibiOS/RT SIMPOSIX port files.
+PORTSRC = ${CHIBIOS}/os/rt/ports/SIMPOSIX/chcore.c
+
+PORTASM = 
+
+PORTINC = ${CHIBIOS}/os/rt/ports/SIMPOSIX/compilers/GCC \
+          ${CHIBIOS}/os/rt/ports/SIMPOSIX
@@ -52,10 +52,23 @@
 #define H_UNLOCK(h)     chSemSignal(&(h)->h_sem)
 #endif
 
+#if (CH_CFG_HEAP_TLSF == TRUE) || defined(__DOXYGEN__)
+/**
+ * @brief   Block flags, stored in the two lower bits of the block size.
+ */
+#define H_FREE          ((size_t)1U)
+#define H_LAST          ((size_t)2U)
+#define H_FLAGS         (H_FREE | H_LAST)
+
+#define H_SIZE(p)       ((p)->h.size & ~H_FLAGS)
+#else
+#define H_SIZE(p)       ((p)->h.size)
+#endif
+
 #define LIMIT(p)                                                            \
   /*lint -save -e9087 [11.3] Safe cast.*/                                   \
   (union heap_header *)((uint8_t *)(p) +                                    \
-                        sizeof(union heap_header) + (p)->h.size)            \
+                        sizeof(union heap_header) + H_SIZE(p))              \
   /*lint -restore*/
 
 /*===========================================================================*/
@@ -79,6 +92,169 @@ static memory_heap_t default_heap;
 /* Module local functions.                                                   */
 /*===========================================================================*/
 
+#if (CH_CFG_HEAP_TLSF == TRUE) || defined(__DOXYGEN__)
+/**
+ * @brief   Position of the most significant bit set.
+ *
+ * @param[in] x         the value, must not be zero
+ * @return              The bit position.
+ */
+static unsigned tlsf_msb(size_t x) {
+
+  if ((sizeof (size_t) > sizeof (uint32_t)) && (((uint64_t)x >> 32) != 0U)) {
+    return 63U - ch_clz((uint32_t)((uint64_t)x >> 32));
+  }
+  return 31U - ch_clz((uint32_t)x);
+}
+
+/**
+ * @brief   Calculates the free list of a block size.
+ *
+ * @param[in] size      the block size
+ * @param[out] flp      first level class
+ * @param[out] slp      second level list within the class
+ */
+static void tlsf_mapping(size_t size, unsigned *flp, unsigned *slp) {
+  unsigned f;
+
+  if (size < ((size_t)1U << CH_HEAP_TLSF_FL_SHIFT)) {
+    *flp = 0U;
+    *slp = (unsigned)(size >> CH_HEAP_TLSF_ALIGN_LOG2);
+    return;
+  }
+
+  f = tlsf_msb(size);
+  if (f > (unsigned)CH_CFG_HEAP_TLSF_FL_MAX) {
+    /* Too big, the last list is shared by all the bigger blocks.*/
+    *flp = CH_HEAP_TLSF_FL_COUNT - 1U;
+    *slp = CH_HEAP_TLSF_SL_COUNT - 1U;
+    return;
+  }
+  *flp = f - CH_HEAP_TLSF_FL_SHIFT + 1U;
+  *slp = (unsigned)(size >> (f - (unsigned)CH_CFG_HEAP_TLSF_SL_BITS)) -
+         CH_HEAP_TLSF_SL_COUNT;
+}
+
+/**
+ * @brief   Inserts a free block in its list.
+ *
+ * @param[in] heapp     pointer to the heap descriptor
+ * @param[in] hp        pointer to the block header
+ */
+static void tlsf_insert(memory_heap_t *heapp, union heap_header *hp) {
+  unsigned fl, sl;
+
+  tlsf_mapping(H_SIZE(hp), &fl, &sl);
+  hp->h.u.next = heapp->h_lists[fl][sl];
+  hp->h.prev = NULL;
+  if (hp->h.u.next != NULL) {
+    hp->h.u.next->h.prev = hp;
+  }
+  heapp->h_lists[fl][sl] = hp;
+  heapp->h_slmap[fl] |= (uint32_t)1U << sl;
+  heapp->h_flmap |= (uint32_t)1U << fl;
+}
+
+/**
+ * @brief   Removes a free block from its list.
+ *
+ * @param[in] heapp     pointer to the heap descriptor
+ * @param[in] hp        pointer to the block header
+ */
+static void tlsf_remove(memory_heap_t *heapp, union heap_header *hp) {
+  unsigned fl, sl;
+
+  tlsf_mapping(H_SIZE(hp), &fl, &sl);
+  if (hp->h.u.next != NULL) {
+    hp->h.u.next->h.prev = hp->h.prev;
+  }
+  if (hp->h.prev != NULL) {
+    hp->h.prev->h.u.next = hp->h.u.next;
+    return;
+  }
+  heapp->h_lists[fl][sl] = hp->h.u.next;
+  if (hp->h.u.next == NULL) {
+    heapp->h_slmap[fl] &= ~((uint32_t)1U << sl);
+    if (heapp->h_slmap[fl] == 0U) {
+      heapp->h_flmap &= ~((uint32_t)1U << fl);
+    }
+  }
+}
+
+/**
+ * @brief   Finds a free block not smaller than the specified size.
+ * @details The size is rounded up to the next list boundary so that any
+ *          block in the found list fits, if there is no such list then the
+ *          first block in the list of the exact size is tried.
+ *
+ * @param[in] heapp     pointer to the heap descriptor
+ * @param[in] size      the requested size
+ * @return              The found block header, it is still in its list.
+ * @retval NULL         if there is no suitable block.
+ */
+static union heap_header *tlsf_find(memory_heap_t *heapp, size_t size) {
+  union heap_header *hp;
+  size_t rsize = size;
+  unsigned fl, sl;
+  uint32_t m;
+
+  if (size >= ((size_t)1U << CH_HEAP_TLSF_FL_SHIFT)) {
+    unsigned f = tlsf_msb(size);
+
+    if (f <= (unsigned)CH_CFG_HEAP_TLSF_FL_MAX) {
+      rsize = size +
+              ((size_t)1U << (f - (unsigned)CH_CFG_HEAP_TLSF_SL_BITS)) - 1U;
+    }
+  }
+  tlsf_mapping(rsize, &fl, &sl);
+
+  /* First non-empty list at or after the rounded size list.*/
+  m = heapp->h_slmap[fl] & (0xFFFFFFFFU << sl);
+  if (m == 0U) {
+    m = heapp->h_flmap & (0xFFFFFFFEU << fl);
+    if (m != 0U) {
+      fl = ch_ctz(m);
+      m = heapp->h_slmap[fl];
+    }
+  }
+  if (m != 0U) {
+    /* The last list is not size bounded, the size must be verified.*/
+    hp = heapp->h_lists[fl][ch_ctz(m)];
+    if (H_SIZE(hp) >= size) {
+      return hp;
+    }
+  }
+
+  /* Trying the first block in the list of the exact size.*/
+  tlsf_mapping(size, &fl, &sl);
+  hp = heapp->h_lists[fl][sl];
+  if ((hp != NULL) && (H_SIZE(hp) >= size)) {
+    return hp;
+  }
+
+  return NULL;
+}
+
+/**
+ * @brief   Initializes the free lists of a heap.
+ *
+ * @param[in] heapp     pointer to the heap descriptor
+ */
+static void tlsf_init(memory_heap_t *heapp) {
+  unsigned fl, sl;
+
+  chDbgAssert(MEM_ALIGN_SIZE >= 4U, "alignment too small");
+
+  heapp->h_flmap = 0U;
+  for (fl = 0U; fl < CH_HEAP_TLSF_FL_COUNT; fl++) {
+    heapp->h_slmap[fl] = 0U;
+    for (sl = 0U; sl < CH_HEAP_TLSF_SL_COUNT; sl++) {
+      heapp->h_lists[fl][sl] = NULL;
+    }
+  }
+}
+#endif /* CH_CFG_HEAP_TLSF == TRUE */
+
 /*===========================================================================*/
 /* Module exported functions.                                                */
 /*===========================================================================*/
@@ -91,8 +267,12 @@ static memory_heap_t default_heap;
 void _heap_init(void) {
 
   default_heap.h_provider = chCoreAlloc;
+#if CH_CFG_HEAP_TLSF == TRUE
+  tlsf_init(&default_heap);
+#else
   default_heap.h_free.h.u.next = NULL;
   default_heap.h_free.h.size = 0;
+#endif
 #if (CH_CFG_USE_MUTEXES == TRUE) || defined(__DOXYGEN__)
   chMtxObjectInit(&default_heap.h_mtx);
 #else
@@ -117,10 +297,17 @@ void chHeapObjectInit(memory_heap_t *heapp, void *buf, size_t size) {
   chDbgCheck(MEM_IS_ALIGNED(buf) && MEM_IS_ALIGNED(size));
 
   heapp->h_provider = NULL;
+#if CH_CFG_HEAP_TLSF == TRUE
+  tlsf_init(heapp);
+  hp->h.size = (size - sizeof(union heap_header)) | H_FREE | H_LAST;
+  hp->h.phys = NULL;
+  tlsf_insert(heapp, hp);
+#else
   heapp->h_free.h.u.next = hp;
   heapp->h_free.h.size = 0;
   hp->h.u.next = NULL;
   hp->h.size = size - sizeof(union heap_header);
+#endif
 #if (CH_CFG_USE_MUTEXES == TRUE) || defined(__DOXYGEN__)
   chMtxObjectInit(&heapp->h_mtx);
 #else
@@ -133,6 +320,8 @@ void chHeapObjectInit(memory_heap_t *heapp, void *buf, size_t size) {
  *          algorithm.
  * @details The allocated block is guaranteed to be properly aligned for a
  *          pointer data type (@p stkalign_t).
+ * @note    If @p CH_CFG_HEAP_TLSF is enabled then the block is found in
+ *          constant time using a good-fit policy instead.
  *
  * @param[in] heapp     pointer to a heap descriptor or @p NULL in order to
  *                      access the default heap.
@@ -145,13 +334,52 @@ void chHeapObjectInit(memory_heap_t *heapp, void *buf, size_t size) {
  * @api
  */
 void *chHeapAlloc(memory_heap_t *heapp, size_t size) {
-  union heap_header *qp, *hp, *fp;
+#if CH_CFG_HEAP_TLSF == FALSE
+  union heap_header *qp;
+#endif
+  union heap_header *hp, *fp;
 
   if (heapp == NULL) {
     heapp = &default_heap;
   }
 
   size = MEM_ALIGN_NEXT(size);
+
+#if CH_CFG_HEAP_TLSF == TRUE
+  H_LOCK(heapp);
+  hp = tlsf_find(heapp, size);
+  if (hp != NULL) {
+    tlsf_remove(heapp, hp);
+    if (H_SIZE(hp) >= (size + sizeof(union heap_header))) {
+      /* Block bigger enough, must split it, the fragment inherits the
+         last block flag.*/
+      /*lint -save -e9087 [11.3] Safe cast.*/
+      fp = (void *)((uint8_t *)(hp) + sizeof(union heap_header) + size);
+      /*lint -restore*/
+      fp->h.size = ((H_SIZE(hp) - sizeof(union heap_header)) - size) |
+                   H_FREE | (hp->h.size & H_LAST);
+      fp->h.phys = hp;
+      if ((fp->h.size & H_LAST) == 0U) {
+        (LIMIT(fp))->h.phys = fp;
+      }
+      tlsf_insert(heapp, fp);
+      hp->h.size = size;
+    }
+    else {
+      /* Gets the whole block even if it is slightly bigger than the
+         requested size because the fragment would be too small to be
+         useful.*/
+      hp->h.size &= ~H_FREE;
+    }
+    hp->h.u.heap = heapp;
+    H_UNLOCK(heapp);
+
+    /*lint -save -e9087 [11.3] Safe cast.*/
+    return (void *)(hp + 1);
+    /*lint -restore*/
+  }
+  H_UNLOCK(heapp);
+#else /* CH_CFG_HEAP_TLSF == FALSE */
   qp = &heapp->h_free;
 
   H_LOCK(heapp);
@@ -184,6 +412,7 @@ void *chHeapAlloc(memory_heap_t *heapp, size_t size) {
     qp = hp;
   }
   H_UNLOCK(heapp);
+#endif /* CH_CFG_HEAP_TLSF == FALSE */
 
   /* More memory is required, tries to get it from the associated provider
      else fails.*/
@@ -191,7 +420,13 @@ void *chHeapAlloc(memory_heap_t *heapp, size_t size) {
     hp = heapp->h_provider(size + sizeof(union heap_header));
     if (hp != NULL) {
       hp->h.u.heap = heapp;
+#if CH_CFG_HEAP_TLSF == TRUE
+      /* The block is not adjacent to any other block of the heap.*/
+      hp->h.size = size | H_LAST;
+      hp->h.phys = NULL;
+#else
       hp->h.size = size;
+#endif
       hp++;
 
       /*lint -save -e9087 [11.3] Safe cast.*/
@@ -211,7 +446,11 @@ void *chHeapAlloc(memory_heap_t *heapp, size_t size) {
  * @api
  */
 void chHeapFree(void *p) {
+#if CH_CFG_HEAP_TLSF == TRUE
+  union heap_header *hp, *np;
+#else
   union heap_header *qp, *hp;
+#endif
   memory_heap_t *heapp;
 
   chDbgCheck(p != NULL);
@@ -220,6 +459,38 @@ void chHeapFree(void *p) {
   hp = (union heap_header *)p - 1;
   /*lint -restore*/
   heapp = hp->h.u.heap;
+
+#if CH_CFG_HEAP_TLSF == TRUE
+  H_LOCK(heapp);
+  chDbgAssert((hp->h.size & H_FREE) == 0U, "already free");
+
+  /* Merge with the next block.*/
+  if ((hp->h.size & H_LAST) == 0U) {
+    np = LIMIT(hp);
+    if ((np->h.size & H_FREE) != 0U) {
+      tlsf_remove(heapp, np);
+      hp->h.size += H_SIZE(np) + sizeof(union heap_header);
+      hp->h.size |= np->h.size & H_LAST;
+    }
+  }
+
+  /* Merge with the previous block.*/
+  np = hp->h.phys;
+  if ((np != NULL) && ((np->h.size & H_FREE) != 0U)) {
+    tlsf_remove(heapp, np);
+    np->h.size += H_SIZE(hp) + sizeof(union heap_header);
+    np->h.size |= hp->h.size & H_LAST;
+    hp = np;
+  }
+
+  /* The block after the merged one must point back to it.*/
+  if ((hp->h.size & H_LAST) == 0U) {
+    (LIMIT(hp))->h.phys = hp;
+  }
+  hp->h.size |= H_FREE;
+  tlsf_insert(heapp, hp);
+  H_UNLOCK(heapp);
+#else /* CH_CFG_HEAP_TLSF == FALSE */
   qp = &heapp->h_free;
 
   H_LOCK(heapp);
@@ -247,42 +518,76 @@ void chHeapFree(void *p) {
     qp = qp->h.u.next;
   }
   H_UNLOCK(heapp);
+#endif /* CH_CFG_HEAP_TLSF == FALSE */
 
   return;
 }
 
 /**
  * @brief   Reports the heap status.
- * @note    This function is meant to be used in the test suite, it should
- *          not be really useful for the application code.
+ * @note    This function is meant to be used in the test suite and for
+ *          diagnostics, it scans all the free blocks.
+ * @note    The fragmentation can be estimated comparing the largest free
+ *          block with the total free space.
  *
  * @param[in] heapp     pointer to a heap descriptor or @p NULL in order to
  *                      access the default heap.
- * @param[in] sizep     pointer to a variable that will receive the total
- *                      fragmented free space
+ * @param[in] totalp    pointer to a variable that will receive the total
+ *                      fragmented free space or @p NULL
+ * @param[in] largestp  pointer to a variable that will receive the size of
+ *                      the largest free block or @p NULL
  * @return              The number of fragments in the heap.
  *
  * @api
  */
-size_t chHeapStatus(memory_heap_t *heapp, size_t *sizep) {
+size_t chHeapStatus(memory_heap_t *heapp, size_t *totalp, size_t *largestp) {
   union heap_header *qp;
-  size_t n, sz;
+  size_t n, tsize, lsize;
 
   if (heapp == NULL) {
     heapp = &default_heap;
   }
 
   H_LOCK(heapp);
-  sz = 0;
-  n = 0;
+  tsize = 0U;
+  lsize = 0U;
+  n = 0U;
+#if CH_CFG_HEAP_TLSF == TRUE
+  {
+    unsigned fl, sl;
+
+    for (fl = 0U; fl < CH_HEAP_TLSF_FL_COUNT; fl++) {
+      for (sl = 0U; sl < CH_HEAP_TLSF_SL_COUNT; sl++) {
+        for (qp = heapp->h_lists[fl][sl]; qp != NULL; qp = qp->h.u.next) {
+          size_t size = H_SIZE(qp);
+
+          tsize += size;
+          if (size > lsize) {
+            lsize = size;
+          }
+          n++;
+        }
+      }
+    }
+  }
+#else
   qp = &heapp->h_free;
   while (qp->h.u.next != NULL) {
-    sz += qp->h.u.next->h.size;
+    size_t size = qp->h.u.next->h.size;
+
+    tsize += size;
+    if (size > lsize) {
+      lsize = size;
+    }
     n++;
     qp = qp->h.u.next;
   }
-  if (sizep != NULL) {
-    *sizep = sz;
+#endif
+  if (totalp != NULL) {
+    *totalp = tsize;
+  }
+  if (largestp != NULL) {
+    *largestp = lsize;
   }
   H_UNLOCK(heapp);
 
@@ -55,6 +55,37 @@
 /* Module local functions.                                                   */
 /*===========================================================================*/
 
+#if (CH_CFG_USE_POOL_MAGAZINES == TRUE) || defined(__DOXYGEN__)
+/**
+ * @brief   Returns cached objects of a magazine to its pool.
+ * @details The objects are linked outside the critical zone, the list is
+ *          then spliced into the pool in constant time.
+ *
+ * @param[in] pmp       pointer to a @p pool_magazine_t structure
+ * @param[in] n         number of objects to be returned, not zero and not
+ *                      greater than the cached objects
+ */
+static void magazine_drain(pool_magazine_t *pmp, size_t n) {
+  struct pool_header *first, *last;
+
+  first = pmp->pm_next;
+  last = first;
+  pmp->pm_cnt -= n;
+  while (n > 1U) {
+    last = last->ph_next;
+    n--;
+  }
+  pmp->pm_next = last->ph_next;
+
+  chSysLock();
+  last->ph_next = pmp->pm_pool->mp_next;
+  pmp->pm_pool->mp_next = first;
+  chSysUnlock();
+
+  pmp->pm_stats.pms_drains++;
+}
+#endif /* CH_CFG_USE_POOL_MAGAZINES == TRUE */
+
 /*===========================================================================*/
 /* Module exported functions.                                                */
 /*===========================================================================*/
@@ -197,6 +228,135 @@ void chPoolFree(memory_pool_t *mp, void *objp) {
   chSysUnlock();
 }
 
+#if (CH_CFG_USE_POOL_MAGAZINES == TRUE) || defined(__DOXYGEN__)
+/**
+ * @brief   Initializes an empty memory pool magazine.
+ * @note    A magazine must be used by a single thread, its operations do
+ *          not lock the system except when exchanging objects with the
+ *          pool.
+ *
+ * @param[out] pmp      pointer to a @p pool_magazine_t structure
+ * @param[in] mp        pointer to the associated @p memory_pool_t structure
+ * @param[in] size      maximum number of cached objects
+ * @param[in] batch     number of objects fetched from the pool when the
+ *                      magazine is empty and returned to the pool when the
+ *                      magazine is full, it cannot exceed @p size
+ *
+ * @init
+ */
+void chPoolMagazineObjectInit(pool_magazine_t *pmp, memory_pool_t *mp,
+                              size_t size, size_t batch) {
+
+  chDbgCheck((pmp != NULL) && (mp != NULL) &&
+             (batch > 0U) && (batch <= size));
+
+  pmp->pm_pool = mp;
+  pmp->pm_next = NULL;
+  pmp->pm_cnt = 0U;
+  pmp->pm_size = size;
+  pmp->pm_batch = batch;
+  pmp->pm_stats.pms_hits = (ucnt_t)0;
+  pmp->pm_stats.pms_misses = (ucnt_t)0;
+  pmp->pm_stats.pms_refills = (ucnt_t)0;
+  pmp->pm_stats.pms_drains = (ucnt_t)0;
+}
+
+/**
+ * @brief   Allocates an object through a magazine.
+ * @details If the magazine is empty then a batch of objects is fetched from
+ *          the pool, the pool provider is invoked if the pool runs empty.
+ *
+ * @param[in] pmp       pointer to a @p pool_magazine_t structure
+ * @return              The pointer to the allocated object.
+ * @retval NULL         if both the magazine and the pool are empty.
+ *
+ * @api
+ */
+void *chPoolMagazineAlloc(pool_magazine_t *pmp) {
+  struct pool_header *php;
+
+  chDbgCheck(pmp != NULL);
+
+  if (pmp->pm_next == NULL) {
+    size_t n = 0U;
+
+    /* Refilling the magazine with a single critical zone.*/
+    pmp->pm_stats.pms_misses++;
+    chSysLock();
+    while (n < pmp->pm_batch) {
+      php = chPoolAllocI(pmp->pm_pool);
+      if (php == NULL) {
+        break;
+      }
+      php->ph_next = pmp->pm_next;
+      pmp->pm_next = php;
+      n++;
+    }
+    chSysUnlock();
+
+    if (n == 0U) {
+      return NULL;
+    }
+    pmp->pm_cnt = n;
+    pmp->pm_stats.pms_refills++;
+  }
+  else {
+    pmp->pm_stats.pms_hits++;
+  }
+
+  php = pmp->pm_next;
+  pmp->pm_next = php->ph_next;
+  pmp->pm_cnt--;
+
+  return (void *)php;
+}
+
+/**
+ * @brief   Releases an object through a magazine.
+ * @details If the magazine is full then a batch of objects is returned to
+ *          the pool first.
+ * @pre     The freed object must be of the right size for the associated
+ *          memory pool.
+ * @pre     The object must be properly aligned to contain a pointer to void.
+ *
+ * @param[in] pmp       pointer to a @p pool_magazine_t structure
+ * @param[in] objp      the pointer to the object to be released
+ *
+ * @api
+ */
+void chPoolMagazineFree(pool_magazine_t *pmp, void *objp) {
+  struct pool_header *php = objp;
+
+  chDbgCheck((pmp != NULL) && (objp != NULL));
+
+  if (pmp->pm_cnt >= pmp->pm_size) {
+    magazine_drain(pmp, pmp->pm_batch);
+  }
+
+  php->ph_next = pmp->pm_next;
+  pmp->pm_next = php;
+  pmp->pm_cnt++;
+}
+
+/**
+ * @brief   Returns all the cached objects of a magazine to its pool.
+ * @note    This function should be invoked before the owner thread
+ *          terminates or before disposing the magazine.
+ *
+ * @param[in] pmp       pointer to a @p pool_magazine_t structure
+ *
+ * @api
+ */
+void chPoolMagazineFlush(pool_magazine_t *pmp) {
+
+  chDbgCheck(pmp != NULL);
+
+  if (pmp->pm_cnt > 0U) {
+    magazine_drain(pmp, pmp->pm_cnt);
+  }
+}
+#endif /* CH_CFG_USE_POOL_MAGAZINES == TRUE */
+
 #endif /* CH_CFG_USE_MEMPOOLS == TRUE */
 
 /** @} */
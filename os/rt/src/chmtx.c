@@ -163,6 +163,8 @@ void chMtxLockS(mutex_t *mp) {
       /* Does the running thread have higher priority than the mutex
          owning thread? */
       while (tp->p_prio < ctp->p_prio) {
+        tprio_t oldprio = tp->p_prio;
+
         /* Make priority of thread tp match the running thread's priority.*/
         tp->p_prio = ctp->p_prio;
 
@@ -199,7 +201,7 @@ void chMtxLockS(mutex_t *mp) {
           tp->p_state = CH_STATE_CURRENT;
 #endif
           /* Re-enqueues tp with its new priority on the ready list.*/
-          (void) chSchReadyI(queue_dequeue(tp));
+          (void) chSchReadyI(_scheduler_dequeue(tp, oldprio));
           break;
         default:
           /* Nothing to do for other states.*/
@@ -53,6 +53,80 @@ ch_system_t ch;
 /* Module local functions.                                                   */
 /*===========================================================================*/
 
+#if (CH_CFG_SCHED_BITMAP == TRUE) || defined(__DOXYGEN__)
+/**
+ * @brief   Finds the lowest ready priority not lower than the specified one.
+ *
+ * @param[in] prio      the priority level, can be @p ABSPRIO + 1
+ * @return              The found priority level.
+ * @retval NOPRIO       if there are no ready threads at or above @p prio.
+ */
+static tprio_t rlist_find(unsigned prio) {
+  unsigned w = prio >> 5;
+  uint32_t m;
+
+  if (w >= CH_SCHED_BITMAP_WORDS) {
+    return NOPRIO;
+  }
+  m = ch.rlist.r_map[w] & (0xFFFFFFFFU << (prio & 31U));
+  if (m == 0U) {
+    /* Nothing in the same word, the first non-empty word above.*/
+    m = ch.rlist.r_mapgrp & (0xFFFFFFFEU << w);
+    if (m == 0U) {
+      return NOPRIO;
+    }
+    w = ch_ctz(m);
+    m = ch.rlist.r_map[w];
+  }
+
+  return (tprio_t)((w << 5) + ch_ctz(m));
+}
+
+/**
+ * @brief   Marks a priority level as having ready threads.
+ *
+ * @param[in] prio      the priority level
+ */
+static void rlist_mark(tprio_t prio) {
+  unsigned w = (unsigned)prio >> 5;
+
+  ch.rlist.r_map[w] |= (uint32_t)1U << ((unsigned)prio & 31U);
+  ch.rlist.r_mapgrp |= (uint32_t)1U << w;
+}
+
+/**
+ * @brief   Marks a priority level as having no ready threads.
+ *
+ * @param[in] prio      the priority level
+ */
+static void rlist_unmark(tprio_t prio) {
+  unsigned w = (unsigned)prio >> 5;
+
+  ch.rlist.r_map[w] &= ~((uint32_t)1U << ((unsigned)prio & 31U));
+  if (ch.rlist.r_map[w] == 0U) {
+    ch.rlist.r_mapgrp &= ~((uint32_t)1U << w);
+  }
+}
+#endif /* CH_CFG_SCHED_BITMAP == TRUE */
+
+/**
+ * @brief   Removes the highest priority thread from the ready list.
+ *
+ * @return              The removed thread pointer.
+ */
+static inline thread_t *rlist_remove(void) {
+  thread_t *tp = queue_fifo_remove(&ch.rlist.r_queue);
+
+#if CH_CFG_SCHED_BITMAP == TRUE
+  /* It was the only ready thread at its priority.*/
+  if (ch.rlist.r_tail[tp->p_prio] == tp) {
+    rlist_unmark(tp->p_prio);
+  }
+#endif
+
+  return tp;
+}
+
 /*===========================================================================*/
 /* Module exported functions.                                                */
 /*===========================================================================*/
@@ -66,12 +140,52 @@ void _scheduler_init(void) {
 
   queue_init(&ch.rlist.r_queue);
   ch.rlist.r_prio = NOPRIO;
+#if CH_CFG_SCHED_BITMAP == TRUE
+  {
+    unsigned i;
+
+    ch.rlist.r_mapgrp = 0U;
+    for (i = 0U; i < CH_SCHED_BITMAP_WORDS; i++) {
+      ch.rlist.r_map[i] = 0U;
+    }
+  }
+#endif
 #if CH_CFG_USE_REGISTRY == TRUE
   ch.rlist.r_newer = (thread_t *)&ch.rlist;
   ch.rlist.r_older = (thread_t *)&ch.rlist;
 #endif
 }
 
+/**
+ * @brief   Removes a ready thread from the ready list.
+ * @details The thread is removed regardless of its position, the priority
+ *          it was inserted with must be specified because the caller could
+ *          have already changed it.
+ *
+ * @param[in] tp        the pointer to the thread to be removed
+ * @param[in] prio      the priority the thread was made ready with
+ * @return              The removed thread pointer.
+ *
+ * @notapi
+ */
+thread_t *_scheduler_dequeue(thread_t *tp, tprio_t prio) {
+
+#if CH_CFG_SCHED_BITMAP == TRUE
+  if (ch.rlist.r_tail[prio] == tp) {
+    if (tp->p_prev->p_prio == prio) {
+      ch.rlist.r_tail[prio] = tp->p_prev;
+    }
+    else {
+      rlist_unmark(prio);
+    }
+  }
+#else
+  (void)prio;
+#endif
+
+  return queue_dequeue(tp);
+}
+
 #if (CH_CFG_OPTIMIZE_SPEED == FALSE) || defined(__DOXYGEN__)
 /**
  * @brief   Inserts a thread into a priority ordered queue.
@@ -225,6 +339,23 @@ thread_t *chSchReadyI(thread_t *tp) {
               "invalid state");
 
   tp->p_state = CH_STATE_READY;
+#if CH_CFG_SCHED_BITMAP == TRUE
+  {
+    /* The thread goes behind the last thread with the lowest priority
+       not lower than its own, no list scan.*/
+    tprio_t prio = rlist_find((unsigned)tp->p_prio);
+
+    cp = (prio == NOPRIO) ? (thread_t *)&ch.rlist.r_queue :
+                            ch.rlist.r_tail[prio];
+  }
+  /* Insertion on p_next.*/
+  tp->p_prev = cp;
+  tp->p_next = cp->p_next;
+  tp->p_next->p_prev = tp;
+  cp->p_next = tp;
+  rlist_mark(tp->p_prio);
+  ch.rlist.r_tail[tp->p_prio] = tp;
+#else
   cp = (thread_t *)&ch.rlist.r_queue;
   do {
     cp = cp->p_next;
@@ -234,6 +365,7 @@ thread_t *chSchReadyI(thread_t *tp) {
   tp->p_prev = cp->p_prev;
   tp->p_prev->p_next = tp;
   cp->p_prev = tp;
+#endif
 
   return tp;
 }
@@ -259,7 +391,7 @@ void chSchGoSleepS(tstate_t newstate) {
      time quantum when it will wakeup.*/
   otp->p_preempt = (tslices_t)CH_CFG_TIME_QUANTUM;
 #endif
-  setcurrp(queue_fifo_remove(&ch.rlist.r_queue));
+  setcurrp(rlist_remove());
 #if defined(CH_CFG_IDLE_ENTER_HOOK)
   if (currp->p_prio == IDLEPRIO) {
     CH_CFG_IDLE_ENTER_HOOK();
@@ -457,7 +589,7 @@ void chSchDoRescheduleBehind(void) {
 
   otp = currp;
   /* Picks the first thread from the ready queue and makes it current.*/
-  setcurrp(queue_fifo_remove(&ch.rlist.r_queue));
+  setcurrp(rlist_remove());
 #if defined(CH_CFG_IDLE_LEAVE_HOOK)
   if (otp->p_prio == IDLEPRIO) {
     CH_CFG_IDLE_LEAVE_HOOK();
@@ -485,7 +617,7 @@ void chSchDoRescheduleAhead(void) {
 
   otp = currp;
   /* Picks the first thread from the ready queue and makes it current.*/
-  setcurrp(queue_fifo_remove(&ch.rlist.r_queue));
+  setcurrp(rlist_remove());
 #if defined(CH_CFG_IDLE_LEAVE_HOOK)
   if (otp->p_prio == IDLEPRIO) {
     CH_CFG_IDLE_LEAVE_HOOK();
@@ -494,6 +626,25 @@ void chSchDoRescheduleAhead(void) {
   currp->p_state = CH_STATE_CURRENT;
 
   otp->p_state = CH_STATE_READY;
+#if CH_CFG_SCHED_BITMAP == TRUE
+  {
+    /* The thread goes behind the last thread with higher priority.*/
+    tprio_t prio = rlist_find((unsigned)otp->p_prio + 1U);
+
+    cp = (prio == NOPRIO) ? (thread_t *)&ch.rlist.r_queue :
+                            ch.rlist.r_tail[prio];
+  }
+  /* Insertion on p_next.*/
+  otp->p_prev = cp;
+  otp->p_next = cp->p_next;
+  otp->p_next->p_prev = otp;
+  cp->p_next = otp;
+  if (otp->p_next->p_prio != otp->p_prio) {
+    /* No other ready threads at the same priority.*/
+    rlist_mark(otp->p_prio);
+    ch.rlist.r_tail[otp->p_prio] = otp;
+  }
+#else
   cp = (thread_t *)&ch.rlist.r_queue;
   do {
     cp = cp->p_next;
@@ -503,6 +654,7 @@ void chSchDoRescheduleAhead(void) {
   otp->p_prev = cp->p_prev;
   otp->p_prev->p_next = otp;
   cp->p_prev = otp;
+#endif
 
   chSysSwitch(currp, otp);
 }
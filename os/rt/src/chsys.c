@@ -39,6 +39,16 @@
 /* Module exported variables.                                                */
 /*===========================================================================*/
 
+#if !defined(port_clz) || !defined(port_ctz) || defined(__DOXYGEN__)
+/**
+ * @brief   Bit positions indexed by the De Bruijn sequence 0x077CB531.
+ */
+const uint8_t ch_bit_index[32] = {
+   0,  1, 28,  2, 29, 14, 24,  3, 30, 22, 20, 15, 25, 17,  4,  8,
+  31, 27, 13, 23, 21, 19, 16,  7, 26, 12, 18,  6, 11,  5, 10,  9
+};
+#endif
+
 /*===========================================================================*/
 /* Module local types.                                                       */
 /*===========================================================================*/
@@ -223,6 +233,15 @@ bool chSysIntegrityCheckI(unsigned testmask) {
     tp = ch.rlist.r_queue.p_next;
     while (tp != (thread_t *)&ch.rlist.r_queue) {
       n++;
+#if CH_CFG_SCHED_BITMAP == TRUE
+      /* The last thread of each priority must be indexed by the bitmap.*/
+      if ((tp->p_next->p_prio != tp->p_prio) &&
+          ((ch.rlist.r_tail[tp->p_prio] != tp) ||
+           ((ch.rlist.r_map[(unsigned)tp->p_prio >> 5] &
+             ((uint32_t)1U << ((unsigned)tp->p_prio & 31U))) == 0U))) {
+        return true;
+      }
+#endif
       tp = tp->p_next;
     }
 
@@ -237,11 +256,60 @@ bool chSysIntegrityCheckI(unsigned testmask) {
     if (n != (cnt_t)0) {
       return true;
     }
+
+#if CH_CFG_SCHED_BITMAP == TRUE
+    /* Each marked priority must index a queued thread of that priority.*/
+    for (n = (cnt_t)1; n <= (cnt_t)ABSPRIO; n++) {
+      if ((ch.rlist.r_map[(unsigned)n >> 5] &
+           ((uint32_t)1U << ((unsigned)n & 31U))) != 0U) {
+        tp = ch.rlist.r_tail[n];
+        if ((tp == NULL) || (tp->p_prio != (tprio_t)n) ||
+            (tp->p_state != CH_STATE_READY)) {
+          return true;
+        }
+      }
+    }
+#endif
   }
 
   /* Timers list integrity check.*/
   if ((testmask & CH_INTEGRITY_VTLIST) != 0U) {
     virtual_timer_t * vtp;
+#if CH_CFG_VT_WHEEL == TRUE
+    unsigned l, s;
+
+    for (l = 0U; l < CH_VT_WHEEL_LEVELS; l++) {
+      for (s = 0U; s < CH_VT_WHEEL_SLOTS; s++) {
+        virtual_timer_t *sp = (virtual_timer_t *)&ch.vtlist.vt_wheel[l][s];
+
+        /* Scanning the slot list forward.*/
+        n = (cnt_t)0;
+        vtp = sp->vt_next;
+        while (vtp != sp) {
+          n++;
+          vtp = vtp->vt_next;
+        }
+
+        /* The slot must be marked if and only if not empty.*/
+        if ((n != (cnt_t)0) !=
+            ((ch.vtlist.vt_map[l] & ((uint32_t)1U << s)) != 0U)) {
+          return true;
+        }
+
+        /* Scanning the slot list backward.*/
+        vtp = sp->vt_prev;
+        while (vtp != sp) {
+          n--;
+          vtp = vtp->vt_prev;
+        }
+
+        /* The number of elements must match.*/
+        if (n != (cnt_t)0) {
+          return true;
+        }
+      }
+    }
+#endif
 
     /* Scanning the timers list forward.*/
     n = (cnt_t)0;
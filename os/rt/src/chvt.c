@@ -32,6 +32,41 @@
 /* Module local definitions.                                                 */
 /*===========================================================================*/
 
+#if (CH_CFG_VT_WHEEL == TRUE) || defined(__DOXYGEN__)
+/**
+ * @brief   Current time of the timing wheel.
+ * @details All timers expiring at or before this time have been processed,
+ *          the slot of each armed timer is relative to this time.
+ */
+#if (CH_CFG_ST_TIMEDELTA == 0) || defined(__DOXYGEN__)
+#define VT_WHEEL_TIME           ch.vtlist.vt_systime
+#else
+#define VT_WHEEL_TIME           ch.vtlist.vt_lasttime
+#endif
+
+/**
+ * @brief   Mask of a single level digit.
+ */
+#define VT_WHEEL_MASK           (CH_VT_WHEEL_SLOTS - 1U)
+
+/**
+ * @brief   Bit position of the digit of level @p l.
+ */
+#define VT_WHEEL_SHIFT(l)       ((unsigned)(l) * (unsigned)CH_CFG_VT_WHEEL_BITS)
+
+/**
+ * @brief   Digit of level @p l of the time @p t.
+ */
+#define VT_WHEEL_DIGIT(t, l)                                                \
+  (((unsigned)(t) >> VT_WHEEL_SHIFT(l)) & VT_WHEEL_MASK)
+
+/**
+ * @brief   Mask of the digits below level @p l.
+ */
+#define VT_WHEEL_LOWMASK(l)                                                 \
+  ((systime_t)(((uint32_t)1U << VT_WHEEL_SHIFT(l)) - 1U))
+#endif /* CH_CFG_VT_WHEEL == TRUE */
+
 /*===========================================================================*/
 /* Module exported variables.                                                */
 /*===========================================================================*/
@@ -48,6 +83,217 @@
 /* Module local functions.                                                   */
 /*===========================================================================*/
 
+#if (CH_CFG_VT_WHEEL == TRUE) || defined(__DOXYGEN__)
+/**
+ * @brief   Time at which a wheel slot is processed.
+ * @details This is the time at which the digit of the slot level equals
+ *          the slot index and all the lower digits are zero.
+ *
+ * @param[in] l         the wheel level
+ * @param[in] s         the slot index
+ * @return              The absolute processing time of the slot.
+ */
+static systime_t wheel_slot_time(unsigned l, unsigned s) {
+  systime_t mask = (systime_t)(VT_WHEEL_MASK << VT_WHEEL_SHIFT(l)) |
+                   VT_WHEEL_LOWMASK(l);
+
+  return (systime_t)((VT_WHEEL_TIME & (systime_t)~mask) |
+                     (systime_t)(s << VT_WHEEL_SHIFT(l)));
+}
+
+/**
+ * @brief   Inserts a timer in the timing wheel.
+ * @details The timer is placed in the level of the most significant digit
+ *          where its expiration time differs from the wheel time. Timers
+ *          expiring after the wrap of the system time are placed in the
+ *          first slot of the top level, the one processed at the wrap.
+ *
+ * @param[in] vtp       the @p virtual_timer_t structure pointer, the
+ *                      @p vt_delta field contains the expiration time
+ * @return              The processing time of the slot.
+ */
+static systime_t wheel_insert(virtual_timer_t *vtp) {
+  virtual_timers_slot_t *sp;
+  systime_t t = vtp->vt_delta;
+  uint32_t x = (uint32_t)t ^ (uint32_t)VT_WHEEL_TIME;
+  unsigned l, s;
+
+  if (t < VT_WHEEL_TIME) {
+    l = CH_VT_WHEEL_LEVELS - 1U;
+    s = 0U;
+  }
+  else {
+    l = (x == 0U) ? 0U :
+        (31U - ch_clz(x)) / (unsigned)CH_CFG_VT_WHEEL_BITS;
+    s = VT_WHEEL_DIGIT(t, l);
+  }
+
+  /* The timer is appended to the slot list.*/
+  sp = &ch.vtlist.vt_wheel[l][s];
+  vtp->vt_next = (virtual_timer_t *)sp;
+  vtp->vt_prev = sp->vt_prev;
+  vtp->vt_prev->vt_next = vtp;
+  sp->vt_prev = vtp;
+  ch.vtlist.vt_map[l] |= (uint32_t)1U << s;
+
+  if ((l == CH_VT_WHEEL_LEVELS - 1U) && (s == 0U)) {
+    /* Processed at the wrap of the system time.*/
+    return (systime_t)0;
+  }
+  return wheel_slot_time(l, s);
+}
+
+/**
+ * @brief   Checks if the timing wheel is empty.
+ *
+ * @return              The wheel state.
+ * @retval true         if there are no armed timers.
+ */
+static bool wheel_is_empty(void) {
+  unsigned l;
+
+  for (l = 0U; l < CH_VT_WHEEL_LEVELS; l++) {
+    if (ch.vtlist.vt_map[l] != 0U) {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+/**
+ * @brief   Time interval from the wheel time to the next slot processing.
+ * @note    The next event can be a cascade of a slot to the lower levels,
+ *          so the interval can be shorter than the one to the next timer
+ *          expiration.
+ * @pre     The wheel must not be empty.
+ *
+ * @return              The interval, in ticks.
+ */
+static systime_t wheel_next_offset(void) {
+  systime_t offset = (systime_t)-1;
+  unsigned l;
+
+  for (l = 0U; l < CH_VT_WHEEL_LEVELS; l++) {
+    uint32_t map = ch.vtlist.vt_map[l];
+    uint32_t m;
+    systime_t o;
+
+    if (map == 0U) {
+      continue;
+    }
+
+    /* Slots after the current digit are processed in this rotation, the
+       shift is done in two steps because the digit can be 31.*/
+    m = map & ((0xFFFFFFFFU << VT_WHEEL_DIGIT(VT_WHEEL_TIME, l)) << 1);
+    if (m != 0U) {
+      o = wheel_slot_time(l, ch_ctz(m)) - VT_WHEEL_TIME;
+    }
+    else {
+      /* Only the wrap slot can be at or before the current digit.*/
+      chDbgAssert((l == CH_VT_WHEEL_LEVELS - 1U) && (map == 1U),
+                  "wheel corrupted");
+      o = (systime_t)0 - VT_WHEEL_TIME;
+    }
+
+    if (o < offset) {
+      offset = o;
+    }
+  }
+
+  return offset;
+}
+
+/**
+ * @brief   Advances the timing wheel to the specified time.
+ * @details The slots processed at the specified time are cascaded to the
+ *          lower levels, then the timers expiring at that time are
+ *          triggered.
+ * @note    There must be no slot to be processed between the current wheel
+ *          time and the specified time.
+ * @note    The system lock is released before entering the callbacks and
+ *          re-acquired immediately after.
+ *
+ * @param[in] t         the new wheel time
+ */
+static void wheel_step(systime_t t) {
+  virtual_timers_slot_t pend;
+  virtual_timers_slot_t *sp;
+  unsigned l, s;
+
+  VT_WHEEL_TIME = t;
+
+  /* Cascading the slots whose lower digits just wrapped to zero.*/
+  for (l = CH_VT_WHEEL_LEVELS - 1U; l > 0U; l--) {
+    if ((t & VT_WHEEL_LOWMASK(l)) != (systime_t)0) {
+      continue;
+    }
+    s = VT_WHEEL_DIGIT(t, l);
+    if ((ch.vtlist.vt_map[l] & ((uint32_t)1U << s)) == 0U) {
+      continue;
+    }
+
+    /* The slot list is detached and its timers inserted again relative
+       to the new wheel time.*/
+    sp = &ch.vtlist.vt_wheel[l][s];
+    pend.vt_next = sp->vt_next;
+    pend.vt_prev = sp->vt_prev;
+    pend.vt_prev->vt_next = (virtual_timer_t *)&pend;
+    sp->vt_next = (virtual_timer_t *)sp;
+    sp->vt_prev = (virtual_timer_t *)sp;
+    ch.vtlist.vt_map[l] &= ~((uint32_t)1U << s);
+    while (pend.vt_next != (virtual_timer_t *)&pend) {
+      virtual_timer_t *vtp = pend.vt_next;
+
+      pend.vt_next = vtp->vt_next;
+      (void) wheel_insert(vtp);
+    }
+  }
+
+  /* Timers expiring at this time.*/
+  s = VT_WHEEL_DIGIT(t, 0U);
+  if ((ch.vtlist.vt_map[0] & ((uint32_t)1U << s)) == 0U) {
+    return;
+  }
+
+  /* The slot list is detached so that the callbacks can arm timers in
+     the same slot again.*/
+  sp = &ch.vtlist.vt_wheel[0][s];
+  pend.vt_next = sp->vt_next;
+  pend.vt_prev = sp->vt_prev;
+  pend.vt_next->vt_prev = (virtual_timer_t *)&pend;
+  pend.vt_prev->vt_next = (virtual_timer_t *)&pend;
+  sp->vt_next = (virtual_timer_t *)sp;
+  sp->vt_prev = (virtual_timer_t *)sp;
+  ch.vtlist.vt_map[0] &= ~((uint32_t)1U << s);
+
+#if CH_CFG_ST_TIMEDELTA > 0
+  /* if the wheel becomes empty then the timer is stopped.*/
+  if (wheel_is_empty()) {
+    port_timer_stop_alarm();
+  }
+#endif
+
+  while (pend.vt_next != (virtual_timer_t *)&pend) {
+    virtual_timer_t *vtp = pend.vt_next;
+    vtfunc_t fn;
+
+    chDbgAssert(vtp->vt_delta == t, "wheel corrupted");
+
+    vtp->vt_next->vt_prev = (virtual_timer_t *)&pend;
+    pend.vt_next = vtp->vt_next;
+    fn = vtp->vt_func;
+    vtp->vt_func = NULL;
+
+    /* The callback is invoked outside the kernel critical zone, it can
+       reset the other timers still in the pending list.*/
+    chSysUnlockFromISR();
+    fn(vtp->vt_par);
+    chSysLockFromISR();
+  }
+}
+#endif /* CH_CFG_VT_WHEEL == TRUE */
+
 /*===========================================================================*/
 /* Module exported functions.                                                */
 /*===========================================================================*/
@@ -59,6 +305,9 @@
  * @notapi
  */
 void _vt_init(void) {
+#if CH_CFG_VT_WHEEL == TRUE
+  unsigned l, s;
+#endif
 
   ch.vtlist.vt_next = (virtual_timer_t *)&ch.vtlist;
   ch.vtlist.vt_prev = (virtual_timer_t *)&ch.vtlist;
@@ -68,6 +317,17 @@ void _vt_init(void) {
 #else /* CH_CFG_ST_TIMEDELTA > 0 */
   ch.vtlist.vt_lasttime = (systime_t)0;
 #endif /* CH_CFG_ST_TIMEDELTA > 0 */
+#if CH_CFG_VT_WHEEL == TRUE
+  for (l = 0U; l < CH_VT_WHEEL_LEVELS; l++) {
+    ch.vtlist.vt_map[l] = 0U;
+    for (s = 0U; s < CH_VT_WHEEL_SLOTS; s++) {
+      ch.vtlist.vt_wheel[l][s].vt_next =
+          (virtual_timer_t *)&ch.vtlist.vt_wheel[l][s];
+      ch.vtlist.vt_wheel[l][s].vt_prev =
+          (virtual_timer_t *)&ch.vtlist.vt_wheel[l][s];
+    }
+  }
+#endif /* CH_CFG_VT_WHEEL == TRUE */
 }
 
 /**
@@ -94,8 +354,10 @@ void _vt_init(void) {
  */
 void chVTDoSetI(virtual_timer_t *vtp, systime_t delay,
                 vtfunc_t vtfunc, void *par) {
+#if CH_CFG_VT_WHEEL == FALSE
   virtual_timer_t *p;
   systime_t delta;
+#endif
 
   chDbgCheckClassI();
   chDbgCheck((vtp != NULL) && (vtfunc != NULL) && (delay != TIME_IMMEDIATE));
@@ -103,6 +365,52 @@ void chVTDoSetI(virtual_timer_t *vtp, systime_t delay,
   vtp->vt_par = par;
   vtp->vt_func = vtfunc;
 
+#if CH_CFG_VT_WHEEL == TRUE
+#if CH_CFG_ST_TIMEDELTA > 0
+  {
+    systime_t now = chVTGetSystemTimeX();
+    systime_t delta, alarm;
+
+    /* If the requested delay is lower than the minimum safe delta then it
+       is raised to the minimum safe value.*/
+    if (delay < (systime_t)CH_CFG_ST_TIMEDELTA) {
+      delay = (systime_t)CH_CFG_ST_TIMEDELTA;
+    }
+
+    /* Special case where the wheel is empty, the current time becomes the
+       new wheel time and the alarm timer is started.*/
+    if (wheel_is_empty()) {
+      ch.vtlist.vt_lasttime = now;
+      vtp->vt_delta = now + delay;
+      delta = wheel_insert(vtp) - now;
+      if (delta < (systime_t)CH_CFG_ST_TIMEDELTA) {
+        delta = (systime_t)CH_CFG_ST_TIMEDELTA;
+      }
+      port_timer_start_alarm(now + delta);
+
+      return;
+    }
+
+    /* If the slot of the new timer is processed before the current alarm
+       then the alarm is moved earlier, not closer than
+       CH_CFG_ST_TIMEDELTA ticks from now.*/
+    vtp->vt_delta = now + delay;
+    delta = wheel_insert(vtp) - ch.vtlist.vt_lasttime;
+    alarm = port_timer_get_alarm() - ch.vtlist.vt_lasttime;
+    if (delta < (systime_t)(now - ch.vtlist.vt_lasttime +
+                            (systime_t)CH_CFG_ST_TIMEDELTA)) {
+      delta = now - ch.vtlist.vt_lasttime + (systime_t)CH_CFG_ST_TIMEDELTA;
+    }
+    if (delta < alarm) {
+      port_timer_set_alarm(ch.vtlist.vt_lasttime + delta);
+    }
+  }
+#else /* CH_CFG_ST_TIMEDELTA == 0 */
+  /* The expiration time is stored in place of the delta.*/
+  vtp->vt_delta = ch.vtlist.vt_systime + delay;
+  (void) wheel_insert(vtp);
+#endif /* CH_CFG_ST_TIMEDELTA == 0 */
+#else /* CH_CFG_VT_WHEEL == FALSE */
 #if CH_CFG_ST_TIMEDELTA > 0
   {
     systime_t now = chVTGetSystemTimeX();
@@ -164,6 +472,7 @@ void chVTDoSetI(virtual_timer_t *vtp, systime_t delay,
      value in the header must be restored.*/;
   p->vt_delta -= delta;
   ch.vtlist.vt_delta = (systime_t)-1;
+#endif /* CH_CFG_VT_WHEEL == FALSE */
 }
 
 /**
@@ -180,7 +489,36 @@ void chVTDoResetI(virtual_timer_t *vtp) {
   chDbgCheck(vtp != NULL);
   chDbgAssert(vtp->vt_func != NULL, "timer not set or already triggered");
 
-#if CH_CFG_ST_TIMEDELTA == 0
+#if CH_CFG_VT_WHEEL == TRUE
+  {
+    virtual_timers_slot_t *sp = (virtual_timers_slot_t *)vtp->vt_next;
+
+    /* Removing the element from its slot list.*/
+    vtp->vt_prev->vt_next = vtp->vt_next;
+    vtp->vt_next->vt_prev = vtp->vt_prev;
+    vtp->vt_func = NULL;
+
+    /* If the timer was the only one in its slot then the slot is marked
+       as empty, a timer being triggered is in a detached list instead.*/
+    if ((vtp->vt_next == vtp->vt_prev) &&
+        (sp >= &ch.vtlist.vt_wheel[0][0]) &&
+        (sp < &ch.vtlist.vt_wheel[CH_VT_WHEEL_LEVELS - 1U][0] +
+              CH_VT_WHEEL_SLOTS)) {
+      unsigned i = (unsigned)(sp - &ch.vtlist.vt_wheel[0][0]);
+
+      ch.vtlist.vt_map[i / CH_VT_WHEEL_SLOTS] &=
+          ~((uint32_t)1U << (i % CH_VT_WHEEL_SLOTS));
+
+#if CH_CFG_ST_TIMEDELTA > 0
+      /* If the wheel became empty then the alarm timer is stopped, else
+         the current alarm is left as is, an early alarm is harmless.*/
+      if (wheel_is_empty()) {
+        port_timer_stop_alarm();
+      }
+#endif
+    }
+  }
+#elif CH_CFG_ST_TIMEDELTA == 0
 
   /* The delta of the timer is added to the next timer.*/
   vtp->vt_next->vt_delta += vtp->vt_delta;
@@ -254,4 +592,91 @@ void chVTDoResetI(virtual_timer_t *vtp) {
 #endif /* CH_CFG_ST_TIMEDELTA > 0 */
 }
 
+#if (CH_CFG_VT_WHEEL == TRUE) || defined(__DOXYGEN__)
+/**
+ * @brief   Returns the time interval until the next timer event.
+ * @note    The return value is not perfectly accurate and can report values
+ *          in excess of @p CH_CFG_ST_TIMEDELTA ticks.
+ * @note    The next event can be the cascade of a wheel slot, the returned
+ *          interval can be shorter than the one to the next timer
+ *          expiration.
+ *
+ * @param[out] timep    pointer to a variable that will contain the time
+ *                      interval until the next timer elapses. This pointer
+ *                      can be @p NULL if the information is not required.
+ * @return              The time, in ticks, until next time event.
+ * @retval false        if the timers list is empty.
+ * @retval true         if the timers list contains at least one timer.
+ *
+ * @iclass
+ */
+bool chVTGetTimersStateI(systime_t *timep) {
+
+  chDbgCheckClassI();
+
+  if (wheel_is_empty()) {
+    return false;
+  }
+
+  if (timep != NULL) {
+#if CH_CFG_ST_TIMEDELTA == 0
+    *timep = wheel_next_offset();
+#else
+    *timep = VT_WHEEL_TIME + wheel_next_offset() +
+             CH_CFG_ST_TIMEDELTA - chVTGetSystemTimeX();
+#endif
+  }
+
+  return true;
+}
+
+/**
+ * @brief   Virtual timers ticker.
+ * @note    The system lock is released before entering the callback and
+ *          re-acquired immediately after. It is callback's responsibility
+ *          to acquire the lock if needed. This is done in order to reduce
+ *          interrupts jitter when many timers are in use.
+ *
+ * @iclass
+ */
+void chVTDoTickI(void) {
+#if CH_CFG_ST_TIMEDELTA == 0
+
+  chDbgCheckClassI();
+
+  wheel_step(ch.vtlist.vt_systime + (systime_t)1);
+#else /* CH_CFG_ST_TIMEDELTA > 0 */
+  systime_t now, delta;
+
+  chDbgCheckClassI();
+
+  /* All the slots within the time window are processed, the current time
+     could advance while the callbacks are executed.*/
+  now = chVTGetSystemTimeX();
+  while (!wheel_is_empty()) {
+    delta = wheel_next_offset();
+    if (delta > (systime_t)(now - ch.vtlist.vt_lasttime)) {
+      break;
+    }
+    wheel_step(ch.vtlist.vt_lasttime + delta);
+    now = chVTGetSystemTimeX();
+  }
+
+  /* if the wheel is empty, nothing else to do.*/
+  if (wheel_is_empty()) {
+    return;
+  }
+
+  /* There are no slots to be processed up to the current time so the
+     wheel time can be moved forward, then the next alarm is calculated.*/
+  ch.vtlist.vt_lasttime = now;
+  delta = wheel_next_offset();
+  if (delta < (systime_t)CH_CFG_ST_TIMEDELTA) {
+    delta = (systime_t)CH_CFG_ST_TIMEDELTA;
+  }
+  port_timer_set_alarm(now + delta);
+#endif /* CH_CFG_ST_TIMEDELTA > 0 */
+}
+#endif /* CH_CFG_VT_WHEEL == TRUE */
+
 /** @} */
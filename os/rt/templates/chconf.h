@@ -122,6 +122,39 @@
  */
 #define CH_CFG_OPTIMIZE_SPEED               TRUE
 
+/**
+ * @brief   Bitmap indexed ready list.
+ * @details If enabled then the insertion of a thread in the ready list is
+ *          a constant time operation regardless of the number of ready
+ *          threads, a priorities bitmap is used instead of a list scan.
+ *
+ * @note    Requires (ABSPRIO + 1) pointers of extra RAM.
+ * @note    The default is @p FALSE.
+ */
+#define CH_CFG_SCHED_BITMAP                 FALSE
+
+/**
+ * @brief   Hierarchical timing wheel for virtual timers.
+ * @details If enabled then the virtual timers are kept in a hierarchical
+ *          timing wheel instead of a delta list, arming and disarming a
+ *          timer are constant time operations regardless of the number of
+ *          armed timers.
+ *
+ * @note    Requires two pointers of extra RAM for each wheel slot.
+ * @note    The default is @p FALSE.
+ */
+#define CH_CFG_VT_WHEEL                     FALSE
+
+/**
+ * @brief   Timing wheel bits per level.
+ * @details Each wheel level has 2^N slots, enough levels are allocated to
+ *          cover the whole system time range.
+ *
+ * @note    The allowed range is 1...5.
+ * @note    The default is 4.
+ */
+#define CH_CFG_VT_WHEEL_BITS                4
+
 /** @} */
 
 /*===========================================================================*/
@@ -290,6 +323,18 @@
  */
 #define CH_CFG_USE_HEAP                     TRUE
 
+/**
+ * @brief   Two levels segregated fit heap allocator.
+ * @details If enabled then the heap free blocks are kept in size segregated
+ *          lists (TLSF), allocation and release are constant time
+ *          operations and the fragmentation is bounded.
+ *
+ * @note    The default is @p FALSE.
+ * @note    Requires @p CH_CFG_USE_HEAP.
+ * @note    Adds two pointers to each block header.
+ */
+#define CH_CFG_HEAP_TLSF                    FALSE
+
 /**
  * @brief   Memory Pools Allocator APIs.
  * @details If enabled then the memory pools allocator APIs are included
@@ -299,6 +344,16 @@
  */
 #define CH_CFG_USE_MEMPOOLS                 TRUE
 
+/**
+ * @brief   Memory Pool magazines APIs.
+ * @details If enabled then the per-thread memory pool magazines APIs are
+ *          included in the kernel.
+ *
+ * @note    The default is @p FALSE.
+ * @note    Requires @p CH_CFG_USE_MEMPOOLS.
+ */
+#define CH_CFG_USE_POOL_MAGAZINES           FALSE
+
 /**
  * @brief   Dynamic Threads APIs.
  * @details If enabled then the dynamic threads creation APIs are included
@@ -49,6 +49,9 @@
  * - @subpage test_benchmarks_011
  * - @subpage test_benchmarks_012
  * - @subpage test_benchmarks_013
+ * - @subpage test_benchmarks_014
+ * - @subpage test_benchmarks_015
+ * - @subpage test_benchmarks_016
  * .
  * @file testbmk.c Kernel Benchmarks
  * @brief Kernel Benchmarks source file
@@ -690,6 +693,189 @@ ROMCONST struct testcase testbmk13 = {
   bmk13_execute
 };
 
+/**
+ * @page test_benchmarks_014 Ready list insertion with many ready threads
+ *
+ * <h2>Description</h2>
+ * Up to sixteen thread descriptors are made ready at a priority lower than
+ * the test thread so they never run. Another descriptor, at the same
+ * priority, is inserted in the ready list behind all of them and removed
+ * into a continuous loop.<br>
+ * The performance is calculated by measuring the number of iterations after
+ * a second of continuous operations, with @p CH_CFG_SCHED_BITMAP enabled
+ * it does not depend on the number of ready threads.
+ */
+
+#define BMK14_MAX_THREADS   16U
+
+static void bmk14_execute(void) {
+  thread_t *tdp = (thread_t *)test.buffer;
+  tprio_t prio = chThdGetPriorityX() - 1;
+  unsigned i, nthds;
+  uint32_t n = 0;
+
+  /* The descriptors are never started, the working areas buffer is just
+     used as storage.*/
+  nthds = (sizeof(union test_buffers) / sizeof(thread_t)) - 1U;
+  if (nthds > BMK14_MAX_THREADS)
+    nthds = BMK14_MAX_THREADS;
+  for (i = 0; i <= nthds; i++) {
+    tdp[i].p_prio = prio;
+    tdp[i].p_state = CH_STATE_SUSPENDED;
+  }
+
+  /* The test thread must not sleep while the descriptors are in the ready
+     list.*/
+  test_wait_tick();
+  test_start_timer(1000);
+  chSysLock();
+  for (i = 0; i < nthds; i++)
+    (void) chSchReadyI(&tdp[i]);
+  chSysUnlock();
+  do {
+    chSysLock();
+    tdp[nthds].p_state = CH_STATE_SUSPENDED;
+    (void) chSchReadyI(&tdp[nthds]);
+    (void) _scheduler_dequeue(&tdp[nthds], prio);
+    chSysUnlock();
+    n++;
+#if defined(SIMULATOR)
+    _sim_check_for_interrupts();
+#endif
+  } while (!test_timer_done);
+  chSysLock();
+  for (i = 0; i < nthds; i++)
+    (void) _scheduler_dequeue(&tdp[i], prio);
+  chSysUnlock();
+
+  test_print("--- Score : ");
+  test_printn(n);
+  test_print(" ready+remove/S, ");
+  test_printn(nthds);
+  test_println(" ready threads");
+}
+
+ROMCONST struct testcase testbmk14 = {
+  "Benchmark, ready list with many ready threads",
+  NULL,
+  NULL,
+  bmk14_execute
+};
+
+/**
+ * @page test_benchmarks_015 Virtual Timers set/reset with many armed timers
+ *
+ * <h2>Description</h2>
+ * Up to sixty-four virtual timers are armed with delays longer than the
+ * test duration. Another timer, expiring after all of them, is set and
+ * immediately reset into a continuous loop.<br>
+ * The performance is calculated by measuring the number of iterations after
+ * a second of continuous operations, with @p CH_CFG_VT_WHEEL enabled it
+ * does not depend on the number of armed timers.
+ */
+
+#define BMK15_MAX_TIMERS    64U
+
+static void bmk15_execute(void) {
+  virtual_timer_t *vtp = (virtual_timer_t *)test.buffer;
+  unsigned i, ntmrs;
+  uint32_t n = 0;
+
+  ntmrs = (sizeof(union test_buffers) / sizeof(virtual_timer_t)) - 1U;
+  if (ntmrs > BMK15_MAX_TIMERS)
+    ntmrs = BMK15_MAX_TIMERS;
+  for (i = 0; i <= ntmrs; i++)
+    chVTObjectInit(&vtp[i]);
+
+  test_wait_tick();
+  test_start_timer(1000);
+  chSysLock();
+  for (i = 0; i < ntmrs; i++)
+    chVTDoSetI(&vtp[i], MS2ST(2000) + (systime_t)i, tmo, NULL);
+  chSysUnlock();
+  do {
+    chSysLock();
+    chVTDoSetI(&vtp[ntmrs], MS2ST(3000), tmo, NULL);
+    chVTDoResetI(&vtp[ntmrs]);
+    chSysUnlock();
+    n++;
+#if defined(SIMULATOR)
+    _sim_check_for_interrupts();
+#endif
+  } while (!test_timer_done);
+  chSysLock();
+  for (i = 0; i < ntmrs; i++)
+    chVTDoResetI(&vtp[i]);
+  chSysUnlock();
+
+  test_print("--- Score : ");
+  test_printn(n);
+  test_print(" set+reset/S, ");
+  test_printn(ntmrs);
+  test_println(" armed timers");
+}
+
+ROMCONST struct testcase testbmk15 = {
+  "Benchmark, virtual timers with many armed timers",
+  NULL,
+  NULL,
+  bmk15_execute
+};
+
+#if CH_CFG_USE_POOL_MAGAZINES || defined(__DOXYGEN__)
+/**
+ * @page test_benchmarks_016 Memory pool magazines producer/consumer
+ *
+ * <h2>Description</h2>
+ * Objects are allocated through a producer magazine and released through
+ * a consumer magazine into a continuous loop, the objects flow from the
+ * pool to the producer magazine and from the consumer magazine back to the
+ * pool in batches.<br>
+ * The performance is calculated by measuring the number of iterations after
+ * a second of continuous operations.
+ */
+
+#define BMK16_OBJ_SIZE      16U
+
+static void bmk16_execute(void) {
+  static memory_pool_t mp;
+  static pool_magazine_t pmprod, pmcons;
+  uint32_t n = 0;
+
+  chPoolObjectInit(&mp, BMK16_OBJ_SIZE, NULL);
+  chPoolLoadArray(&mp, test.buffer,
+                  sizeof(union test_buffers) / BMK16_OBJ_SIZE);
+  chPoolMagazineObjectInit(&pmprod, &mp, 16, 8);
+  chPoolMagazineObjectInit(&pmcons, &mp, 16, 8);
+
+  test_wait_tick();
+  test_start_timer(1000);
+  do {
+    chPoolMagazineFree(&pmcons, chPoolMagazineAlloc(&pmprod));
+    n++;
+#if defined(SIMULATOR)
+    _sim_check_for_interrupts();
+#endif
+  } while (!test_timer_done);
+  chPoolMagazineFlush(&pmprod);
+  chPoolMagazineFlush(&pmcons);
+
+  test_print("--- Score : ");
+  test_printn(n);
+  test_print(" alloc+free/S, ");
+  test_printn(chPoolMagazineGetStatsX(&pmprod)->pms_refills +
+              chPoolMagazineGetStatsX(&pmcons)->pms_drains);
+  test_println(" batches");
+}
+
+ROMCONST struct testcase testbmk16 = {
+  "Benchmark, memory pool magazines",
+  NULL,
+  NULL,
+  bmk16_execute
+};
+#endif /* CH_CFG_USE_POOL_MAGAZINES */
+
 /**
  * @brief   Test sequence for benchmarks.
  */
@@ -718,6 +904,11 @@ ROMCONST struct testcase * ROMCONST patternbmk[] = {
   &testbmk12,
 #endif
   &testbmk13,
+  &testbmk14,
+  &testbmk15,
+#if CH_CFG_USE_POOL_MAGAZINES || defined(__DOXYGEN__)
+  &testbmk16,
+#endif
 #endif
   NULL
 };
@@ -136,6 +136,45 @@
 #define CH_CFG_OPTIMIZE_SPEED               TRUE
 #endif
 
+/**
+ * @brief   Bitmap indexed ready list.
+ * @details If enabled then the insertion of a thread in the ready list is
+ *          a constant time operation regardless of the number of ready
+ *          threads, a priorities bitmap is used instead of a list scan.
+ *
+ * @note    Requires (ABSPRIO + 1) pointers of extra RAM.
+ * @note    The default is @p FALSE.
+ */
+#if !defined(CH_CFG_SCHED_BITMAP) || defined(__DOXIGEN__)
+#define CH_CFG_SCHED_BITMAP                 FALSE
+#endif
+
+/**
+ * @brief   Hierarchical timing wheel for virtual timers.
+ * @details If enabled then the virtual timers are kept in a hierarchical
+ *          timing wheel instead of a delta list, arming and disarming a
+ *          timer are constant time operations regardless of the number of
+ *          armed timers.
+ *
+ * @note    Requires two pointers of extra RAM for each wheel slot.
+ * @note    The default is @p FALSE.
+ */
+#if !defined(CH_CFG_VT_WHEEL) || defined(__DOXIGEN__)
+#define CH_CFG_VT_WHEEL                     FALSE
+#endif
+
+/**
+ * @brief   Timing wheel bits per level.
+ * @details Each wheel level has 2^N slots, enough levels are allocated to
+ *          cover the whole system time range.
+ *
+ * @note    The allowed range is 1...5.
+ * @note    The default is 4.
+ */
+#if !defined(CH_CFG_VT_WHEEL_BITS) || defined(__DOXIGEN__)
+#define CH_CFG_VT_WHEEL_BITS                4
+#endif
+
 /** @} */
 
 /*===========================================================================*/
@@ -339,6 +378,20 @@
 #define CH_CFG_USE_HEAP                     TRUE
 #endif
 
+/**
+ * @brief   Two levels segregated fit heap allocator.
+ * @details If enabled then the heap free blocks are kept in size segregated
+ *          lists (TLSF), allocation and release are constant time
+ *          operations and the fragmentation is bounded.
+ *
+ * @note    The default is @p FALSE.
+ * @note    Requires @p CH_CFG_USE_HEAP.
+ * @note    Adds two pointers to each block header.
+ */
+#if !defined(CH_CFG_HEAP_TLSF) || defined(__DOXIGEN__)
+#define CH_CFG_HEAP_TLSF                    FALSE
+#endif
+
 /**
  * @brief   Memory Pools Allocator APIs.
  * @details If enabled then the memory pools allocator APIs are included
@@ -350,6 +403,18 @@
 #define CH_CFG_USE_MEMPOOLS                 TRUE
 #endif
 
+/**
+ * @brief   Memory Pool magazines APIs.
+ * @details If enabled then the per-thread memory pool magazines APIs are
+ *          included in the kernel.
+ *
+ * @note    The default is @p FALSE.
+ * @note    Requires @p CH_CFG_USE_MEMPOOLS.
+ */
+#if !defined(CH_CFG_USE_POOL_MAGAZINES) || defined(__DOXIGEN__)
+#define CH_CFG_USE_POOL_MAGAZINES           FALSE
+#endif
+
 /**
  * @brief   Dynamic Threads APIs.
  * @details If enabled then the dynamic threads creation APIs are included
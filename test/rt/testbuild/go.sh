@@ -117,6 +117,8 @@ test cfg26 "-DCH_DBG_ENABLE_TRACE=TRUE"
 test cfg28 "-DCH_DBG_FILL_THREADS=TRUE"
 test cfg29 "-DCH_DBG_THREADS_PROFILING=FALSE"
 test cfg30 "-DCH_DBG_SYSTEM_STATE_CHECK=TRUE -DCH_DBG_ENABLE_CHECKS=TRUE -DCH_DBG_ENABLE_ASSERTS=TRUE -DCH_DBG_ENABLE_TRACE=TRUE -DCH_DBG_FILL_THREADS=TRUE"
+test cfg31 "-DCH_CFG_HEAP_TLSF=TRUE"
+test cfg32 "-DCH_CFG_HEAP_TLSF=TRUE -DCH_DBG_ENABLE_CHECKS=TRUE -DCH_DBG_ENABLE_ASSERTS=TRUE"
 
 rm *log.txt 2> /dev/null
 echo
@@ -37,6 +37,8 @@
  *
  * <h2>Test Cases</h2>
  * - @subpage test_heap_001
+ * - @subpage test_heap_002
+ * - @subpage test_heap_003
  * .
  * @file testheap.c
  * @brief Heap test source file
@@ -77,7 +79,7 @@ static void heap1_execute(void) {
    * Test on the default heap in order to cover the core allocator at
    * least one time.
    */
-  (void)chHeapStatus(NULL, &sz);
+  (void)chHeapStatus(NULL, &sz, NULL);
   p1 = chHeapAlloc(NULL, SIZE);
   test_assert(1, p1 != NULL, "allocation failed");
   chHeapFree(p1);
@@ -85,7 +87,7 @@ static void heap1_execute(void) {
   test_assert(2, p1 == NULL, "allocation not failed");
 
   /* Initial local heap state.*/
-  (void)chHeapStatus(&test_heap, &sz);
+  (void)chHeapStatus(&test_heap, &sz, NULL);
 
   /* Same order.*/
   p1 = chHeapAlloc(&test_heap, SIZE);
@@ -94,7 +96,7 @@ static void heap1_execute(void) {
   chHeapFree(p1);                               /* Does not merge.*/
   chHeapFree(p2);                               /* Merges backward.*/
   chHeapFree(p3);                               /* Merges both sides.*/
-  test_assert(3, chHeapStatus(&test_heap, &n) == 1, "heap fragmented");
+  test_assert(3, chHeapStatus(&test_heap, &n, NULL) == 1, "heap fragmented");
 
   /* Reverse order.*/
   p1 = chHeapAlloc(&test_heap, SIZE);
@@ -103,39 +105,39 @@ static void heap1_execute(void) {
   chHeapFree(p3);                               /* Merges forward.*/
   chHeapFree(p2);                               /* Merges forward.*/
   chHeapFree(p1);                               /* Merges forward.*/
-  test_assert(4, chHeapStatus(&test_heap, &n) == 1, "heap fragmented");
+  test_assert(4, chHeapStatus(&test_heap, &n, NULL) == 1, "heap fragmented");
 
   /* Small fragments handling.*/
   p1 = chHeapAlloc(&test_heap, SIZE + 1);
   p2 = chHeapAlloc(&test_heap, SIZE);
   chHeapFree(p1);
-  test_assert(5, chHeapStatus(&test_heap, &n) == 2, "invalid state");
+  test_assert(5, chHeapStatus(&test_heap, &n, NULL) == 2, "invalid state");
   p1 = chHeapAlloc(&test_heap, SIZE);
   /* Note, the first situation happens when the alignment size is smaller
      than the header size, the second in the other cases.*/
-  test_assert(6, (chHeapStatus(&test_heap, &n) == 1) ||
-                 (chHeapStatus(&test_heap, &n) == 2), "heap fragmented");
+  test_assert(6, (chHeapStatus(&test_heap, &n, NULL) == 1) ||
+                 (chHeapStatus(&test_heap, &n, NULL) == 2), "heap fragmented");
   chHeapFree(p2);
   chHeapFree(p1);
-  test_assert(7, chHeapStatus(&test_heap, &n) == 1, "heap fragmented");
+  test_assert(7, chHeapStatus(&test_heap, &n, NULL) == 1, "heap fragmented");
 
   /* Skip fragment handling.*/
   p1 = chHeapAlloc(&test_heap, SIZE);
   p2 = chHeapAlloc(&test_heap, SIZE);
   chHeapFree(p1);
-  test_assert(8, chHeapStatus(&test_heap, &n) == 2, "invalid state");
+  test_assert(8, chHeapStatus(&test_heap, &n, NULL) == 2, "invalid state");
   p1 = chHeapAlloc(&test_heap, SIZE * 2);       /* Skips first fragment.*/
   chHeapFree(p1);
   chHeapFree(p2);
-  test_assert(9, chHeapStatus(&test_heap, &n) == 1, "heap fragmented");
+  test_assert(9, chHeapStatus(&test_heap, &n, NULL) == 1, "heap fragmented");
 
   /* Allocate all handling.*/
-  (void)chHeapStatus(&test_heap, &n);
+  (void)chHeapStatus(&test_heap, &n, NULL);
   p1 = chHeapAlloc(&test_heap, n);
-  test_assert(10, chHeapStatus(&test_heap, &n) == 0, "not empty");
+  test_assert(10, chHeapStatus(&test_heap, &n, NULL) == 0, "not empty");
   chHeapFree(p1);
 
-  test_assert(11, chHeapStatus(&test_heap, &n) == 1, "heap fragmented");
+  test_assert(11, chHeapStatus(&test_heap, &n, NULL) == 1, "heap fragmented");
   test_assert(12, n == sz, "size changed");
 }
 
@@ -146,6 +148,127 @@ ROMCONST struct testcase testheap1 = {
   heap1_execute
 };
 
+/**
+ * @page test_heap_002 Largest free block report
+ *
+ * <h2>Description</h2>
+ * The heap is fragmented by releasing every other block of a series, the
+ * reported largest free block must be smaller than the total free space.<br>
+ * The test expects the whole heap to be a single free block again after
+ * releasing all the blocks.
+ */
+
+static void heap2_setup(void) {
+
+  chHeapObjectInit(&test_heap, test.buffer, sizeof(union test_buffers));
+}
+
+static void heap2_execute(void) {
+  void *p1, *p2, *p3, *p4;
+  size_t sz, total, largest;
+
+  /* Initial local heap state.*/
+  test_assert(1, chHeapStatus(&test_heap, &sz, &largest) == 1,
+              "heap fragmented");
+  test_assert(2, largest == sz, "largest block mismatch");
+
+  /* Holes between allocated blocks.*/
+  p1 = chHeapAlloc(&test_heap, SIZE);
+  p2 = chHeapAlloc(&test_heap, SIZE);
+  p3 = chHeapAlloc(&test_heap, SIZE);
+  p4 = chHeapAlloc(&test_heap, SIZE);
+  chHeapFree(p1);
+  chHeapFree(p3);
+  test_assert(3, chHeapStatus(&test_heap, &total, &largest) == 3,
+              "invalid state");
+  test_assert(4, largest == total - (SIZE * 2), "largest block mismatch");
+
+  /* Filling the holes.*/
+  chHeapFree(p2);                               /* Merges both sides.*/
+  test_assert(5, chHeapStatus(&test_heap, &total, &largest) == 2,
+              "invalid state");
+  chHeapFree(p4);                               /* Merges both sides.*/
+  test_assert(6, chHeapStatus(&test_heap, &total, &largest) == 1,
+              "heap fragmented");
+  test_assert(7, (total == sz) && (largest == sz), "size changed");
+}
+
+ROMCONST struct testcase testheap2 = {
+  "Heap, largest free block report",
+  heap2_setup,
+  NULL,
+  heap2_execute
+};
+
+#if (CH_CFG_HEAP_TLSF == TRUE) || defined(__DOXYGEN__)
+/**
+ * @brief   A size one alignment unit above a list boundary, a good fit
+ *          search rounds it up to the next list.
+ */
+#define TLSF_SIZE (((size_t)1U << (CH_HEAP_TLSF_FL_SHIFT + 2U)) +           \
+                   ((size_t)1U << CH_HEAP_TLSF_ALIGN_LOG2))
+
+/**
+ * @page test_heap_003 TLSF split, coalesce and exact list fallback
+ *
+ * <h2>Description</h2>
+ * A block is split off the heap and released again between two allocated
+ * blocks, so that it is the only free block. The good fit search for its
+ * own size finds no list above its own and must fall back to the block
+ * in its exact list, a slightly larger request must fail.<br>
+ * The test expects the whole heap to be a single free block again after
+ * releasing all the blocks.
+ */
+
+static void heap3_setup(void) {
+
+  chHeapObjectInit(&test_heap, test.buffer, sizeof(union test_buffers));
+}
+
+static void heap3_execute(void) {
+  void *p1, *p2, *p3, *p4;
+  size_t sz, total, largest;
+
+  (void)chHeapStatus(&test_heap, &sz, NULL);
+
+  /* Split, a guard block keeps the hole from merging with the rest.*/
+  p1 = chHeapAlloc(&test_heap, TLSF_SIZE);
+  p2 = chHeapAlloc(&test_heap, SIZE);
+  test_assert(1, (p1 != NULL) && (p2 != NULL), "allocation failed");
+  (void)chHeapStatus(&test_heap, &total, &largest);
+  p3 = chHeapAlloc(&test_heap, largest);
+  test_assert(2, chHeapStatus(&test_heap, &total, NULL) == 0, "not empty");
+
+  /* The hole is the only free block.*/
+  chHeapFree(p1);
+  test_assert(3, chHeapStatus(&test_heap, &total, &largest) == 1,
+              "invalid state");
+  test_assert(4, largest == TLSF_SIZE, "hole size mismatch");
+
+  /* Fallback to the exact list.*/
+  p4 = chHeapAlloc(&test_heap, TLSF_SIZE +
+                               ((size_t)1U << CH_HEAP_TLSF_ALIGN_LOG2));
+  test_assert(5, p4 == NULL, "allocation not failed");
+  p4 = chHeapAlloc(&test_heap, TLSF_SIZE);
+  test_assert(6, p4 == p1, "hole not found");
+
+  /* Coalesce.*/
+  chHeapFree(p4);
+  chHeapFree(p3);                               /* Does not merge.*/
+  chHeapFree(p2);                               /* Merges both sides.*/
+  test_assert(7, chHeapStatus(&test_heap, &total, &largest) == 1,
+              "heap fragmented");
+  test_assert(8, (total == sz) && (largest == sz), "size changed");
+}
+
+ROMCONST struct testcase testheap3 = {
+  "Heap, TLSF split, coalesce and exact list fallback",
+  heap3_setup,
+  NULL,
+  heap3_execute
+};
+#endif /* CH_CFG_HEAP_TLSF == TRUE */
+
 #endif /* CH_CFG_USE_HEAP.*/
 
 /**
@@ -154,6 +277,10 @@ ROMCONST struct testcase testheap1 = {
 ROMCONST struct testcase * ROMCONST patternheap[] = {
 #if CH_CFG_USE_HEAP || defined(__DOXYGEN__)
   &testheap1,
+  &testheap2,
+#if CH_CFG_HEAP_TLSF || defined(__DOXYGEN__)
+  &testheap3,
+#endif
 #endif
   NULL
 };
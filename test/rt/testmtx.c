@@ -49,6 +49,7 @@
  * - @subpage test_mtx_006
  * - @subpage test_mtx_007
  * - @subpage test_mtx_008
+ * - @subpage test_mtx_009
  * .
  * @file testmtx.c
  * @brief Mutexes and CondVars test source file
@@ -599,6 +600,65 @@ ROMCONST struct testcase testmtx8 = {
   mtx8_execute
 };
 #endif /* CH_CFG_USE_CONDVARS */
+
+/**
+ * @page test_mtx_009 Priority inheritance on a ready thread
+ *
+ * <h2>Description</h2>
+ * A thread locks a mutex then lowers its priority below the tester thread
+ * so that it is preempted while still owning the mutex, another thread is
+ * ready at the same priority. The tester thread then locks the mutex, the
+ * owner priority is raised while it is in the ready list.<br>
+ * The test expects the ready list to be consistent when the owner runs
+ * with the inherited priority and the threads to run in the right order.
+ */
+
+static void mtx9_setup(void) {
+
+  chMtxObjectInit(&m1);
+}
+
+static THD_FUNCTION(thread9a, p) {
+  bool result;
+
+  chMtxLock(&m1);
+  chThdSetPriority((tprio_t)(uintptr_t)p);
+
+  /* Running again because of the inherited priority, the thread has been
+     moved in the ready list while it was ready.*/
+  chSysLock();
+  result = chSysIntegrityCheckI(CH_INTEGRITY_RLIST);
+  chSysUnlock();
+  test_assert(1, result == false, "ready list check failure");
+  test_emit_token('A');
+  chMtxUnlock(&m1);
+  test_emit_token('C');
+}
+
+static THD_FUNCTION(thread9b, p) {
+
+  test_emit_token(*(char *)p);
+}
+
+static void mtx9_execute(void) {
+  tprio_t prio = chThdGetPriorityX();
+
+  threads[0] = chThdCreateStatic(wa[0], WA_SIZE, prio - 1, thread9b, "D");
+  threads[1] = chThdCreateStatic(wa[1], WA_SIZE, prio + 1, thread9a,
+                                 (void *)(uintptr_t)(prio - 1));
+  chMtxLock(&m1);
+  test_emit_token('B');
+  chMtxUnlock(&m1);
+  test_wait_threads();
+  test_assert_sequence(2, "ABCD");
+}
+
+ROMCONST struct testcase testmtx9 = {
+  "Mutexes, inheritance on a ready thread",
+  mtx9_setup,
+  NULL,
+  mtx9_execute
+};
 #endif /* CH_CFG_USE_MUTEXES */
 
 /**
@@ -618,6 +678,7 @@ ROMCONST struct testcase * ROMCONST patternmtx[] = {
   &testmtx7,
   &testmtx8,
 #endif
+  &testmtx9,
 #endif
   NULL
 };
@@ -37,6 +37,7 @@
  *
  * <h2>Test Cases</h2>
  * - @subpage test_pools_001
+ * - @subpage test_pools_002
  * .
  * @file testpools.c
  * @brief Memory Pools test source file
@@ -104,6 +105,64 @@ ROMCONST struct testcase testpools1 = {
   pools1_execute
 };
 
+#if CH_CFG_USE_POOL_MAGAZINES || defined(__DOXYGEN__)
+/**
+ * @page test_pools_002 Magazines test
+ *
+ * <h2>Description</h2>
+ * Five memory blocks are added to a memory pool then allocated and released
+ * through a magazine holding up to four objects and exchanging them with the
+ * pool two at time.<br>
+ * The test expects to find the magazine statistics and the pool in the
+ * proper status after each sequence.
+ */
+
+static pool_magazine_t pm1;
+
+static void pools2_setup(void) {
+
+  chPoolObjectInit(&mp1, THD_WORKING_AREA_SIZE(THREADS_STACK_SIZE), NULL);
+  chPoolMagazineObjectInit(&pm1, &mp1, 4, 2);
+}
+
+static void pools2_execute(void) {
+  const pool_magazine_stats_t *sp = chPoolMagazineGetStatsX(&pm1);
+  void *objs[MAX_THREADS];
+  int i;
+
+  /* Adding the WAs to the pool.*/
+  chPoolLoadArray(&mp1, wa[0], MAX_THREADS);
+
+  /* Emptying the pool through the magazine, a batch every two objects.*/
+  for (i = 0; i < MAX_THREADS; i++) {
+    objs[i] = chPoolMagazineAlloc(&pm1);
+    test_assert(1, objs[i] != NULL, "list empty");
+  }
+  test_assert(2, chPoolMagazineAlloc(&pm1) == NULL, "list not empty");
+  test_assert(3, (sp->pms_hits == 2) && (sp->pms_misses == 4) &&
+                 (sp->pms_refills == 3), "wrong statistics");
+
+  /* Releasing all, the fifth object makes the magazine return a batch.*/
+  for (i = 0; i < MAX_THREADS; i++)
+    chPoolMagazineFree(&pm1, objs[i]);
+  test_assert(4, sp->pms_drains == 1, "wrong statistics");
+
+  /* All the objects back into the pool.*/
+  chPoolMagazineFlush(&pm1);
+  test_assert(5, sp->pms_drains == 2, "wrong statistics");
+  for (i = 0; i < MAX_THREADS; i++)
+    test_assert(6, chPoolAlloc(&mp1) != NULL, "list empty");
+  test_assert(7, chPoolAlloc(&mp1) == NULL, "list not empty");
+}
+
+ROMCONST struct testcase testpools2 = {
+  "Memory Pools, magazines",
+  pools2_setup,
+  NULL,
+  pools2_execute
+};
+#endif /* CH_CFG_USE_POOL_MAGAZINES */
+
 #endif /* CH_CFG_USE_MEMPOOLS */
 
 /*
@@ -112,6 +171,9 @@ ROMCONST struct testcase testpools1 = {
 ROMCONST struct testcase * ROMCONST patternpools[] = {
 #if CH_CFG_USE_MEMPOOLS || defined(__DOXYGEN__)
   &testpools1,
+#if CH_CFG_USE_POOL_MAGAZINES || defined(__DOXYGEN__)
+  &testpools2,
+#endif
 #endif
   NULL
 };